@@ -0,0 +1,392 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2021 The lai authors
+ */
+
+/* Programmatic AML emitter used to generate synthetic tables. */
+
+#include <acpispec/tables.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../core/aml_opcodes.h"
+#include "aml-builder.h"
+
+__attribute__((noreturn)) static void aml_panic(const char *msg) {
+    fprintf(stderr, "aml-builder: %s\n", msg);
+    abort();
+}
+
+static void aml_reserve(struct aml_builder *b, size_t n) {
+    if (b->size + n <= b->capacity)
+        return;
+    size_t capacity = b->capacity ? b->capacity : 4096;
+    while (capacity < b->size + n)
+        capacity *= 2;
+    b->data = realloc(b->data, capacity);
+    if (!b->data)
+        aml_panic("out of memory");
+    b->capacity = capacity;
+}
+
+void aml_init(struct aml_builder *b, const char *signature) {
+    memset(b, 0, sizeof(struct aml_builder));
+
+    acpi_header_t header;
+    memset(&header, 0, sizeof(acpi_header_t));
+    memcpy(header.signature, signature, 4);
+    header.revision = 2; // Revision 2 enables 64-bit integers.
+    memcpy(header.oem, "LAI   ", 6);
+    memcpy(header.oem_table, "LAISYNTH", 8);
+    header.oem_revision = 1;
+    aml_bytes(b, &header, sizeof(acpi_header_t));
+}
+
+void *aml_finish(struct aml_builder *b, size_t *size) {
+    if (b->depth)
+        aml_panic("aml_finish() called with open objects");
+
+    acpi_header_t *header = (acpi_header_t *)b->data;
+    header->length = b->size;
+    header->checksum = 0;
+
+    uint8_t sum = 0;
+    for (size_t i = 0; i < b->size; i++)
+        sum += b->data[i];
+    header->checksum = -sum;
+
+    void *table = b->data;
+    *size = b->size;
+    memset(b, 0, sizeof(struct aml_builder));
+    return table;
+}
+
+void aml_byte(struct aml_builder *b, uint8_t value) {
+    aml_reserve(b, 1);
+    b->data[b->size++] = value;
+}
+
+void aml_bytes(struct aml_builder *b, const void *data, size_t size) {
+    aml_reserve(b, size);
+    memcpy(b->data + b->size, data, size);
+    b->size += size;
+}
+
+void aml_opcode(struct aml_builder *b, uint8_t opcode) {
+    aml_byte(b, opcode);
+}
+
+void aml_ext_opcode(struct aml_builder *b, uint8_t opcode) {
+    aml_byte(b, EXTOP_PREFIX);
+    aml_byte(b, opcode);
+}
+
+static size_t aml_pkglength_size(size_t value) {
+    if (value < 0x40)
+        return 1;
+    if (value < (1 << 12))
+        return 2;
+    if (value < (1 << 20))
+        return 3;
+    if (value < (1 << 28))
+        return 4;
+    aml_panic("PkgLength is too large");
+}
+
+// Encodes a PkgLength with the given value. Returns the number of bytes written to out.
+static size_t aml_encode_pkglength(uint8_t *out, size_t value) {
+    size_t n = aml_pkglength_size(value);
+    if (n == 1) {
+        out[0] = value;
+        return 1;
+    }
+
+    out[0] = ((n - 1) << 6) | (value & 0x0F);
+    for (size_t i = 1; i < n; i++)
+        out[i] = (value >> (4 + 8 * (i - 1))) & 0xFF;
+    return n;
+}
+
+static void aml_open(struct aml_builder *b) {
+    if (b->depth == AML_BUILDER_MAX_DEPTH)
+        aml_panic("objects are nested too deeply");
+    b->open[b->depth++] = b->size;
+}
+
+void aml_end(struct aml_builder *b) {
+    if (!b->depth)
+        aml_panic("aml_end() without matching aml_begin_*()");
+    size_t start = b->open[--b->depth];
+    size_t length = b->size - start;
+
+    // The PkgLength includes its own encoding.
+    size_t n = 1;
+    while (aml_pkglength_size(length + n) != n)
+        n++;
+    uint8_t encoding[4];
+    aml_encode_pkglength(encoding, length + n);
+
+    aml_reserve(b, n);
+    memmove(b->data + start + n, b->data + start, length);
+    memcpy(b->data + start, encoding, n);
+    b->size += n;
+}
+
+static void aml_nameseg(struct aml_builder *b, const char *seg, size_t length) {
+    if (!length || length > 4)
+        aml_panic("invalid NameSeg");
+    char padded[4] = {'_', '_', '_', '_'};
+    memcpy(padded, seg, length);
+    aml_bytes(b, padded, 4);
+}
+
+void aml_namestring(struct aml_builder *b, const char *path) {
+    if (*path == '\\') {
+        aml_byte(b, ROOT_CHAR);
+        path++;
+    } else {
+        while (*path == '^') {
+            aml_byte(b, PARENT_CHAR);
+            path++;
+        }
+    }
+
+    size_t num_segs = 0;
+    if (*path) {
+        num_segs = 1;
+        for (const char *p = path; *p; p++) {
+            if (*p == '.')
+                num_segs++;
+        }
+    }
+
+    if (!num_segs) {
+        aml_byte(b, 0); // NullName
+        return;
+    } else if (num_segs == 2) {
+        aml_byte(b, DUAL_PREFIX);
+    } else if (num_segs > 2) {
+        if (num_segs > 255)
+            aml_panic("too many segments in NameString");
+        aml_byte(b, MULTI_PREFIX);
+        aml_byte(b, num_segs);
+    }
+
+    while (*path) {
+        const char *end = strchr(path, '.');
+        size_t length = end ? (size_t)(end - path) : strlen(path);
+        aml_nameseg(b, path, length);
+        path += length;
+        if (*path == '.')
+            path++;
+    }
+}
+
+void aml_integer(struct aml_builder *b, uint64_t value) {
+    if (!value) {
+        aml_byte(b, ZERO_OP);
+    } else if (value == 1) {
+        aml_byte(b, ONE_OP);
+    } else if (value == ~(uint64_t)0) {
+        aml_byte(b, ONES_OP);
+    } else if (value <= 0xFF) {
+        aml_byte(b, BYTEPREFIX);
+        aml_byte(b, value);
+    } else if (value <= 0xFFFF) {
+        aml_byte(b, WORDPREFIX);
+        for (int i = 0; i < 2; i++)
+            aml_byte(b, value >> (8 * i));
+    } else if (value <= 0xFFFFFFFF) {
+        aml_byte(b, DWORDPREFIX);
+        for (int i = 0; i < 4; i++)
+            aml_byte(b, value >> (8 * i));
+    } else {
+        aml_byte(b, QWORDPREFIX);
+        for (int i = 0; i < 8; i++)
+            aml_byte(b, value >> (8 * i));
+    }
+}
+
+void aml_string(struct aml_builder *b, const char *str) {
+    aml_byte(b, STRINGPREFIX);
+    aml_bytes(b, str, strlen(str) + 1);
+}
+
+void aml_buffer(struct aml_builder *b, const void *data, size_t size) {
+    aml_byte(b, BUFFER_OP);
+    aml_open(b);
+    aml_integer(b, size);
+    aml_bytes(b, data, size);
+    aml_end(b);
+}
+
+static int aml_hex_digit(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    aml_panic("invalid EISA ID");
+}
+
+void aml_eisaid(struct aml_builder *b, const char *id) {
+    if (strlen(id) != 7)
+        aml_panic("invalid EISA ID");
+
+    // Same encoding as lai_eisaid(): the compressed ID is stored in big endian.
+    uint32_t value = ((id[0] - 0x40) << 26) | ((id[1] - 0x40) << 21) | ((id[2] - 0x40) << 16)
+                     | (aml_hex_digit(id[3]) << 12) | (aml_hex_digit(id[4]) << 8)
+                     | (aml_hex_digit(id[5]) << 4) | aml_hex_digit(id[6]);
+    value = __builtin_bswap32(value);
+    aml_byte(b, DWORDPREFIX);
+    for (int i = 0; i < 4; i++)
+        aml_byte(b, value >> (8 * i));
+}
+
+void aml_local(struct aml_builder *b, int index) {
+    if (index < 0 || index > 7)
+        aml_panic("invalid LocalX");
+    aml_byte(b, LOCAL0_OP + index);
+}
+
+void aml_arg(struct aml_builder *b, int index) {
+    if (index < 0 || index > 6)
+        aml_panic("invalid ArgX");
+    aml_byte(b, ARG0_OP + index);
+}
+
+void aml_name(struct aml_builder *b, const char *name) {
+    aml_byte(b, NAME_OP);
+    aml_namestring(b, name);
+}
+
+void aml_opregion(struct aml_builder *b, const char *name, uint8_t space, uint64_t offset,
+                  uint64_t length) {
+    aml_ext_opcode(b, OPREGION);
+    aml_namestring(b, name);
+    aml_byte(b, space);
+    aml_integer(b, offset);
+    aml_integer(b, length);
+}
+
+void aml_begin_scope(struct aml_builder *b, const char *name) {
+    aml_byte(b, SCOPE_OP);
+    aml_open(b);
+    aml_namestring(b, name);
+}
+
+void aml_begin_device(struct aml_builder *b, const char *name) {
+    aml_ext_opcode(b, DEVICE);
+    aml_open(b);
+    aml_namestring(b, name);
+}
+
+void aml_begin_method(struct aml_builder *b, const char *name, int argc, int serialized) {
+    if (argc < 0 || argc > 7)
+        aml_panic("invalid number of method arguments");
+    aml_byte(b, METHOD_OP);
+    aml_open(b);
+    aml_namestring(b, name);
+    aml_byte(b, argc | (serialized ? METHOD_SERIALIZED : 0));
+}
+
+void aml_begin_package(struct aml_builder *b, size_t num_elements) {
+    if (num_elements <= 0xFF) {
+        aml_byte(b, PACKAGE_OP);
+        aml_open(b);
+        aml_byte(b, num_elements);
+    } else {
+        aml_byte(b, VARPACKAGE_OP);
+        aml_open(b);
+        aml_integer(b, num_elements);
+    }
+}
+
+void aml_begin_field(struct aml_builder *b, const char *region, uint8_t flags) {
+    aml_ext_opcode(b, FIELD);
+    aml_open(b);
+    aml_namestring(b, region);
+    aml_byte(b, flags);
+}
+
+void aml_field_entry(struct aml_builder *b, const char *name, uint32_t bits) {
+    uint8_t encoding[4];
+    aml_nameseg(b, name, strlen(name));
+    aml_bytes(b, encoding, aml_encode_pkglength(encoding, bits));
+}
+
+void aml_field_reserved(struct aml_builder *b, uint32_t bits) {
+    uint8_t encoding[4];
+    aml_byte(b, 0);
+    aml_bytes(b, encoding, aml_encode_pkglength(encoding, bits));
+}
+
+void aml_begin_if(struct aml_builder *b) {
+    aml_byte(b, IF_OP);
+    aml_open(b);
+}
+
+void aml_begin_else(struct aml_builder *b) {
+    aml_byte(b, ELSE_OP);
+    aml_open(b);
+}
+
+void aml_begin_while(struct aml_builder *b) {
+    aml_byte(b, WHILE_OP);
+    aml_open(b);
+}
+
+void aml_return(struct aml_builder *b) {
+    aml_byte(b, RETURN_OP);
+}
+
+void aml_store(struct aml_builder *b) {
+    aml_byte(b, STORE_OP);
+}
+
+void aml_increment(struct aml_builder *b) {
+    aml_byte(b, INCREMENT_OP);
+}
+
+void aml_add(struct aml_builder *b) {
+    aml_byte(b, ADD_OP);
+}
+
+void aml_lless(struct aml_builder *b) {
+    aml_byte(b, LLESS_OP);
+}
+
+void aml_concat(struct aml_builder *b) {
+    aml_byte(b, CONCAT_OP);
+}
+
+void aml_to_hex_string(struct aml_builder *b) {
+    aml_byte(b, TOHEXSTRING_OP);
+}
+
+void aml_sizeof(struct aml_builder *b) {
+    aml_byte(b, SIZEOF_OP);
+}
+
+void aml_index(struct aml_builder *b) {
+    aml_byte(b, INDEX_OP);
+}
+
+void aml_null_target(struct aml_builder *b) {
+    aml_byte(b, 0);
+}
+
+void aml_make_nameseg(char *out, size_t i) {
+    static const char digits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    if (i >= 26 * 36 * 36 * 36)
+        aml_panic("NameSeg index out of range");
+    out[3] = digits[i % 36];
+    i /= 36;
+    out[2] = digits[i % 36];
+    i /= 36;
+    out[1] = digits[i % 36];
+    i /= 36;
+    out[0] = 'A' + i;
+    out[4] = 0;
+}
@@ -0,0 +1,95 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2021 The lai authors
+ */
+
+/* Programmatic AML emitter used to generate synthetic tables.
+ * Objects that have a PkgLength (scopes, devices, methods, packages, etc.) are opened
+ * by an aml_begin_*() function and closed by aml_end(). Terms are emitted in prefix
+ * order, i.e., exactly as they appear in the AML byte stream. */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AML_BUILDER_MAX_DEPTH 64
+
+struct aml_builder {
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+
+    // Offsets of the first byte after the opcode of all open objects.
+    size_t open[AML_BUILDER_MAX_DEPTH];
+    int depth;
+};
+
+// Starts a table with the given signature (e.g. "DSDT" or "SSDT").
+void aml_init(struct aml_builder *b, const char *signature);
+// Fills in the length and checksum of the table. Returns the table;
+// the caller takes ownership and must free() it.
+void *aml_finish(struct aml_builder *b, size_t *size);
+
+// Raw bytes.
+void aml_byte(struct aml_builder *b, uint8_t value);
+void aml_bytes(struct aml_builder *b, const void *data, size_t size);
+void aml_opcode(struct aml_builder *b, uint8_t opcode);
+void aml_ext_opcode(struct aml_builder *b, uint8_t opcode);
+
+// NameString, e.g. "\\_SB_.PCI0", "^PCI0._CRS" or "FOO".
+// Segments shorter than four characters are padded with underscores.
+void aml_namestring(struct aml_builder *b, const char *path);
+
+// Data objects.
+void aml_integer(struct aml_builder *b, uint64_t value);
+void aml_string(struct aml_builder *b, const char *str);
+void aml_buffer(struct aml_builder *b, const void *data, size_t size);
+void aml_eisaid(struct aml_builder *b, const char *id);
+void aml_local(struct aml_builder *b, int index);
+void aml_arg(struct aml_builder *b, int index);
+
+// Named objects.
+void aml_name(struct aml_builder *b, const char *name); // Followed by the value.
+void aml_opregion(struct aml_builder *b, const char *name, uint8_t space, uint64_t offset,
+                  uint64_t length);
+
+// Objects with a PkgLength.
+void aml_begin_scope(struct aml_builder *b, const char *name);
+void aml_begin_device(struct aml_builder *b, const char *name);
+void aml_begin_method(struct aml_builder *b, const char *name, int argc, int serialized);
+// Packages with more than 255 elements are emitted as VarPackage.
+void aml_begin_package(struct aml_builder *b, size_t num_elements);
+// Field(region, flags) { ... }; entries are added by aml_field_entry().
+void aml_begin_field(struct aml_builder *b, const char *region, uint8_t flags);
+void aml_field_entry(struct aml_builder *b, const char *name, uint32_t bits);
+void aml_field_reserved(struct aml_builder *b, uint32_t bits);
+// If/While: the predicate follows directly after the call.
+void aml_begin_if(struct aml_builder *b);
+void aml_begin_else(struct aml_builder *b);
+void aml_begin_while(struct aml_builder *b);
+void aml_end(struct aml_builder *b);
+
+// Commonly used statements.
+void aml_return(struct aml_builder *b); // Followed by the return value.
+void aml_store(struct aml_builder *b);  // Followed by source and target.
+void aml_increment(struct aml_builder *b);
+void aml_add(struct aml_builder *b); // Followed by both operands and the target.
+void aml_lless(struct aml_builder *b);
+void aml_concat(struct aml_builder *b);        // Followed by both operands and the target.
+void aml_to_hex_string(struct aml_builder *b); // Followed by the operand and the target.
+void aml_sizeof(struct aml_builder *b);
+void aml_index(struct aml_builder *b); // Followed by the object, the index and the target.
+void aml_null_target(struct aml_builder *b);
+
+// Generates the i-th NameSeg of the sequence "A000", "A001", ..., "ZZZZ".
+// Writes five bytes (including the terminator). i must be less than 26 * 36^3.
+void aml_make_nameseg(char *out, size_t i);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,468 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2021 The lai authors
+ */
+
+/* Hosted benchmarks for the interpreter.
+ * Usage: lai-bench [-v] [-n iterations] [-N namespace iterations] table.aml...
+ * If no FADT is given, an empty one is synthesized. */
+
+#include <lai/core.h>
+#include <lai/helpers/pci.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host.h"
+
+#define BENCH_MAX_PATHS 256
+
+struct bench_result {
+    const char *name;
+    size_t iterations;
+    size_t failures;
+    uint64_t start_ns;
+    struct bench_alloc_stats start_stats;
+    uint64_t elapsed_ns;
+    struct bench_alloc_stats end_stats;
+};
+
+static void bench_start(struct bench_result *r, const char *name) {
+    memset(r, 0, sizeof(struct bench_result));
+    r->name = name;
+    bench_host_get_stats(&r->start_stats);
+    r->start_ns = bench_host_now_ns();
+}
+
+static void bench_stop(struct bench_result *r, size_t iterations) {
+    r->elapsed_ns = bench_host_now_ns() - r->start_ns;
+    bench_host_get_stats(&r->end_stats);
+    r->iterations = iterations;
+}
+
+static void bench_report(struct bench_result *r) {
+    if (!r->iterations)
+        return;
+    double n = r->iterations;
+    printf("%-28s %10zu %14.1f %12.2f %14.1f", r->name, r->iterations, r->elapsed_ns / n,
+           (r->end_stats.allocs - r->start_stats.allocs) / n,
+           (r->end_stats.bytes - r->start_stats.bytes) / n);
+    if (r->failures)
+        printf("  (%zu failures)", r->failures);
+    printf("\n");
+}
+
+static void bench_report_header(void) {
+    printf("%-28s %10s %14s %12s %14s\n", "benchmark", "iterations", "ns/op", "allocs/op",
+           "bytes/op");
+}
+
+// Finds a node either by absolute path or by the name of its last segment.
+static lai_nsnode_t *bench_find_node(const char *name) {
+    if (*name == '\\')
+        return lai_resolve_path(NULL, name);
+
+    struct lai_ns_iterator iter = LAI_NS_ITERATOR_INITIALIZER;
+    lai_nsnode_t *node;
+    while ((node = lai_ns_iterate(&iter))) {
+        if (!memcmp(node->name, name, 4))
+            return node;
+    }
+    return NULL;
+}
+
+static void bench_eval(const char *name, size_t iterations) {
+    char label[40];
+    snprintf(label, sizeof(label), "lai_eval(%s)", name);
+
+    lai_nsnode_t *node = bench_find_node(name);
+    if (!node) {
+        printf("%-28s skipped, no %s object in the namespace\n", label, name);
+        return;
+    }
+
+    struct bench_result r;
+    bench_start(&r, label);
+    for (size_t i = 0; i < iterations; i++) {
+        LAI_CLEANUP_STATE lai_state_t state;
+        lai_init_state(&state);
+
+        LAI_CLEANUP_VAR lai_variable_t result = LAI_VAR_INITIALIZER;
+        if (lai_eval(&result, node, &state))
+            r.failures++;
+    }
+    bench_stop(&r, iterations);
+    bench_report(&r);
+}
+
+// Compares the setup and teardown cost of fresh and pooled interpreter states.
+static void bench_state(size_t iterations) {
+    struct bench_result r;
+    bench_start(&r, "lai_init_state");
+    for (size_t i = 0; i < iterations; i++) {
+        LAI_CLEANUP_STATE lai_state_t state;
+        lai_init_state(&state);
+        __asm__ volatile("" : : "r"(&state) : "memory");
+    }
+    bench_stop(&r, iterations);
+    bench_report(&r);
+
+    bench_start(&r, "lai_acquire_state");
+    for (size_t i = 0; i < iterations; i++) {
+        LAI_CLEANUP_ACQUIRED_STATE lai_state_t *state = lai_acquire_state();
+        __asm__ volatile("" : : "r"(state) : "memory");
+    }
+    bench_stop(&r, iterations);
+    bench_report(&r);
+}
+
+static void bench_resolve_path(size_t iterations) {
+    static char *paths[BENCH_MAX_PATHS];
+    size_t num_paths = 0;
+
+    struct lai_ns_iterator iter = LAI_NS_ITERATOR_INITIALIZER;
+    lai_nsnode_t *node;
+    while (num_paths < BENCH_MAX_PATHS && (node = lai_ns_iterate(&iter))) {
+        if (node == lai_ns_get_root())
+            continue;
+        char *path = lai_stringify_node_path(node);
+        paths[num_paths++] = strdup(path);
+        laihost_free(path, strlen(path) + 1);
+    }
+    if (!num_paths)
+        return;
+
+    struct bench_result r;
+    bench_start(&r, "lai_resolve_path");
+    for (size_t i = 0; i < iterations; i++) {
+        if (!lai_resolve_path(NULL, paths[i % num_paths]))
+            r.failures++;
+    }
+    bench_stop(&r, iterations);
+    bench_report(&r);
+
+    for (size_t i = 0; i < num_paths; i++)
+        free(paths[i]);
+}
+
+// Resolves a relative path from many devices, like the helpers do.
+static void bench_resolve_relative(const char *path, size_t iterations) {
+    static lai_nsnode_t *devices[BENCH_MAX_PATHS];
+    size_t num_devices = 0;
+
+    struct lai_ns_iterator iter = LAI_NS_ITERATOR_INITIALIZER;
+    lai_nsnode_t *node;
+    while (num_devices < BENCH_MAX_PATHS && (node = lai_ns_iterate(&iter))) {
+        if (lai_ns_get_node_type(node) == LAI_NODETYPE_DEVICE)
+            devices[num_devices++] = node;
+    }
+    if (!num_devices)
+        return;
+
+    char label[40];
+    snprintf(label, sizeof(label), "lai_resolve_path(%s)", path);
+
+    struct bench_result r;
+    bench_start(&r, label);
+    for (size_t i = 0; i < iterations; i++) {
+        if (!lai_resolve_path(devices[i % num_devices], path))
+            r.failures++;
+    }
+    bench_stop(&r, iterations);
+    bench_report(&r);
+}
+
+// Walks all children of a node, like lai_init_children() and the PCI helpers do.
+static void bench_child_iterate(const char *path, size_t iterations) {
+    char label[40];
+    snprintf(label, sizeof(label), "lai_ns_child_iterate(%s)", path);
+
+    lai_nsnode_t *parent = lai_resolve_path(NULL, path);
+    if (!parent) {
+        printf("%-28s skipped, no %s object in the namespace\n", label, path);
+        return;
+    }
+
+    struct bench_result r;
+    bench_start(&r, label);
+    for (size_t i = 0; i < iterations; i++) {
+        struct lai_ns_child_iterator iter = LAI_NS_CHILD_ITERATOR_INITIALIZER(parent);
+        size_t num_children = 0;
+        while (lai_ns_child_iterate(&iter))
+            num_children++;
+        if (!num_children)
+            r.failures++;
+    }
+    bench_stop(&r, iterations);
+    bench_report(&r);
+}
+
+// Finds all devices with a PNP ID, once through lai_enum() and once by evaluating
+// _HID and _CID of every device.
+static void bench_enum(const char *id, size_t iterations) {
+    char label[40];
+    snprintf(label, sizeof(label), "lai_enum(%s)", id);
+
+    struct bench_result r;
+    bench_start(&r, label);
+    for (size_t i = 0; i < iterations; i++) {
+        if (!lai_enum((char *)id, 0))
+            r.failures++;
+        for (size_t n = 1; lai_enum((char *)id, n); n++)
+            ;
+    }
+    bench_stop(&r, iterations);
+    bench_report(&r);
+
+    LAI_CLEANUP_VAR lai_variable_t pnp_id = LAI_VAR_INITIALIZER;
+    lai_eisaid(&pnp_id, id);
+
+    snprintf(label, sizeof(label), "lai_check_device_pnp_id");
+    bench_start(&r, label);
+    for (size_t i = 0; i < iterations; i++) {
+        LAI_CLEANUP_STATE lai_state_t state;
+        lai_init_state(&state);
+
+        // lai_check_device_pnp_id() only looks at _CID if there is no _HID; hence, it can
+        // find fewer devices than lai_enum().
+        struct lai_ns_iterator iter = LAI_NS_ITERATOR_INITIALIZER;
+        lai_nsnode_t *node;
+        while ((node = lai_ns_iterate(&iter))) {
+            if (lai_ns_get_node_type(node) == LAI_NODETYPE_DEVICE)
+                lai_check_device_pnp_id(node, &pnp_id, &state);
+        }
+    }
+    bench_stop(&r, iterations);
+    bench_report(&r);
+}
+
+static void bench_pci_route_pin(size_t iterations) {
+    const char *label = "lai_pci_route_pin";
+
+    // Route the first entry of the _PRT of the root bridge.
+    LAI_CLEANUP_STATE lai_state_t state;
+    lai_init_state(&state);
+
+    lai_nsnode_t *bus = lai_pci_find_bus(0, 0, &state);
+    lai_nsnode_t *prt_node = bus ? lai_resolve_path(bus, "_PRT") : NULL;
+    if (!prt_node) {
+        printf("%-28s skipped, no _PRT for PCI bus 0000:00\n", label);
+        return;
+    }
+
+    LAI_CLEANUP_VAR lai_variable_t prt = LAI_VAR_INITIALIZER;
+    if (lai_eval(&prt, prt_node, &state)) {
+        printf("%-28s skipped, _PRT cannot be evaluated\n", label);
+        return;
+    }
+
+    struct lai_prt_iterator prt_iter = LAI_PRT_ITERATOR_INITIALIZER(&prt);
+    if (lai_pci_parse_prt(&prt_iter)) {
+        printf("%-28s skipped, _PRT has no usable entries\n", label);
+        return;
+    }
+    uint8_t slot = prt_iter.slot;
+    uint8_t function = (prt_iter.function == -1) ? 0 : prt_iter.function;
+    uint8_t pin = prt_iter.pin + 1;
+
+    struct bench_result r;
+    bench_start(&r, label);
+    for (size_t i = 0; i < iterations; i++) {
+        acpi_resource_t resource;
+        if (lai_pci_route_pin(&resource, 0, 0, slot, function, pin))
+            r.failures++;
+    }
+    bench_stop(&r, iterations);
+    bench_report(&r);
+}
+
+static void bench_pci_parse_prt(size_t iterations) {
+    const char *label = "lai_pci_parse_prt";
+
+    // Walk all entries of the _PRT of the root bridge.
+    LAI_CLEANUP_STATE lai_state_t state;
+    lai_init_state(&state);
+
+    lai_nsnode_t *bus = lai_pci_find_bus(0, 0, &state);
+    lai_nsnode_t *prt_node = bus ? lai_resolve_path(bus, "_PRT") : NULL;
+    if (!prt_node) {
+        printf("%-28s skipped, no _PRT for PCI bus 0000:00\n", label);
+        return;
+    }
+
+    struct bench_result r;
+    bench_start(&r, label);
+    for (size_t i = 0; i < iterations; i++) {
+        LAI_CLEANUP_VAR lai_variable_t prt = LAI_VAR_INITIALIZER;
+        if (lai_eval(&prt, prt_node, &state)) {
+            r.failures++;
+            continue;
+        }
+
+        struct lai_prt_iterator prt_iter = LAI_PRT_ITERATOR_INITIALIZER(&prt);
+        while (!lai_pci_parse_prt(&prt_iter))
+            ;
+        if (!prt_iter.i)
+            r.failures++;
+    }
+    bench_stop(&r, iterations);
+    bench_report(&r);
+}
+
+// Saves the namespace and reloads it from the image. The last loaded namespace is kept.
+static void bench_snapshot(size_t iterations) {
+    void *lai_image;
+    size_t size;
+    lai_api_error_t error = lai_save_namespace(&lai_image, &size);
+    if (error) {
+        printf("%-28s skipped, %s\n", "lai_load_namespace", lai_api_error_to_string(error));
+        return;
+    }
+
+    // bench_host_reset_namespace() frees all memory allocated by LAI.
+    void *image = malloc(size);
+    memcpy(image, lai_image, size);
+    laihost_free(lai_image, size);
+
+    struct bench_result r;
+    uint64_t elapsed_ns = 0;
+    struct bench_alloc_stats before, after;
+    uint64_t allocs = 0, bytes = 0;
+    size_t failures = 0;
+    for (size_t i = 0; i < iterations; i++) {
+        bench_host_reset_namespace();
+        bench_host_get_stats(&before);
+        uint64_t start_ns = bench_host_now_ns();
+        if (lai_load_namespace(image, size))
+            failures++;
+        elapsed_ns += bench_host_now_ns() - start_ns;
+        bench_host_get_stats(&after);
+        allocs += after.allocs - before.allocs;
+        bytes += after.bytes - before.bytes;
+    }
+    memset(&r, 0, sizeof(struct bench_result));
+    r.name = "lai_load_namespace";
+    r.iterations = iterations;
+    r.failures = failures;
+    r.elapsed_ns = elapsed_ns;
+    r.end_stats.allocs = allocs;
+    r.end_stats.bytes = bytes;
+    bench_report(&r);
+    printf("snapshot: %zu bytes\n", size);
+    free(image);
+
+    if (failures) {
+        // Continue with a namespace created from the tables.
+        bench_host_reset_namespace();
+        lai_create_namespace();
+    }
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: lai-bench [-v] [-n iterations] [-N namespace iterations] "
+                    "table.aml...\n");
+}
+
+int main(int argc, char **argv) {
+    size_t iterations = 10000;
+    size_t ns_iterations = 20;
+    int num_tables = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-v")) {
+            bench_host_set_verbose(1);
+        } else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            iterations = strtoull(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "-N") && i + 1 < argc) {
+            ns_iterations = strtoull(argv[++i], NULL, 0);
+        } else if (argv[i][0] == '-') {
+            usage();
+            return 1;
+        } else {
+            if (bench_host_load_table(argv[i])) {
+                fprintf(stderr, "lai-bench: could not load table %s\n", argv[i]);
+                return 1;
+            }
+            num_tables++;
+        }
+    }
+
+    if (!num_tables) {
+        usage();
+        return 77; // Tells meson that the benchmark was skipped.
+    }
+    if (!ns_iterations)
+        ns_iterations = 1;
+
+    bench_host_ensure_fadt();
+    lai_set_acpi_revision(2);
+
+    bench_report_header();
+
+    // Each iteration builds a fresh namespace; the last one is kept for the other benchmarks.
+    struct bench_result r;
+    uint64_t elapsed_ns = 0;
+    struct bench_alloc_stats before, after;
+    uint64_t allocs = 0, bytes = 0;
+    for (size_t i = 0; i < ns_iterations; i++) {
+        if (i)
+            bench_host_reset_namespace();
+        bench_host_get_stats(&before);
+        uint64_t start_ns = bench_host_now_ns();
+        lai_create_namespace();
+        elapsed_ns += bench_host_now_ns() - start_ns;
+        bench_host_get_stats(&after);
+        allocs += after.allocs - before.allocs;
+        bytes += after.bytes - before.bytes;
+    }
+    memset(&r, 0, sizeof(struct bench_result));
+    r.name = "lai_create_namespace";
+    r.iterations = ns_iterations;
+    r.elapsed_ns = elapsed_ns;
+    r.end_stats.allocs = allocs;
+    r.end_stats.bytes = bytes;
+    bench_report(&r);
+
+    bench_snapshot(ns_iterations);
+
+    bench_eval("_STA", iterations);
+    bench_eval("_CRS", iterations);
+    bench_eval("_UID", iterations);
+    bench_eval("_PRT", iterations);
+    // Objects of the tables generated by lai-gen.
+    bench_eval("\\_SB_.LOOP", iterations / 100 ? iterations / 100 : 1);
+    bench_eval("\\_SB_.CHN0", iterations);
+    bench_eval("\\_SB_.LOCL", iterations);
+    bench_eval("\\_SB_.THRM._TMP", iterations);
+    bench_eval("\\_SB_.STRS", iterations);
+    bench_eval("\\_SB_.RBUF", iterations);
+    bench_eval("\\_SB_.BPKG", iterations);
+    bench_eval("\\_SB_.PCPY", iterations);
+    bench_state(iterations);
+    bench_resolve_path(iterations);
+    bench_resolve_relative("_STA", iterations);
+    bench_resolve_relative("\\_SB_", iterations);
+    bench_resolve_relative("^^PCI0", iterations);
+    bench_child_iterate("\\_SB_.DEVS", iterations / 100 ? iterations / 100 : 1);
+    bench_enum("PNP0A03", iterations / 100 ? iterations / 100 : 1);
+    bench_pci_route_pin(iterations);
+    bench_pci_parse_prt(iterations / 10 ? iterations / 10 : 1);
+
+    struct bench_alloc_stats stats;
+    bench_host_get_stats(&stats);
+    printf("namespace: %zu nodes, %zu bytes live, %zu bytes peak\n",
+           lai_current_instance()->ns_size, stats.live_bytes, stats.peak_bytes);
+    printf("lai_variable_t: %zu bytes, struct lai_operand: %zu bytes, "
+           "struct lai_invocation: %zu bytes\n",
+           sizeof(lai_variable_t), sizeof(struct lai_operand), sizeof(struct lai_invocation));
+
+    for (int id = 0; id < LAI_SLAB_NUM_CACHES; id++) {
+        struct lai_slab_stats slab;
+        if (lai_slab_get_stats(id, &slab))
+            continue;
+        printf("slab %-12s %4zu bytes/object, %6zu slabs, %8zu in use, %8zu free\n", slab.name,
+               slab.object_size, slab.num_slabs, slab.objects_in_use, slab.objects_free);
+    }
+    return 0;
+}
@@ -0,0 +1,415 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2021 The lai authors
+ */
+
+/* Generates synthetic DSDT/SSDT images for benchmarking.
+ * All sizes can be tuned from the command line, see usage(). */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../core/aml_opcodes.h"
+#include "aml-builder.h"
+
+struct gen_config {
+    const char *signature;
+    size_t devices;
+    size_t depth;
+    size_t fields;
+    size_t package;
+    size_t loop;
+    size_t calls;
+    size_t prt;
+    size_t locals;
+};
+
+// Resource template: IO (Decode16, 0x62, 0x62, 0x01, 0x01) and IRQNoFlags () {irq}.
+static void gen_crs(struct aml_builder *b, int irq) {
+    uint8_t crs[] = {0x47, 0x01, 0x62, 0x00, 0x62, 0x00, 0x01, 0x01, 0x22, 0x00, 0x00, 0x79, 0x00};
+    crs[9] = (1 << irq) & 0xFF;
+    crs[10] = (1 << irq) >> 8;
+    aml_buffer(b, crs, sizeof(crs));
+}
+
+static void gen_sta(struct aml_builder *b) {
+    aml_begin_method(b, "_STA", 0, 0);
+    aml_return(b);
+    aml_integer(b, 0x0F);
+    aml_end(b);
+}
+
+// \_SB_.PCI0: a host bridge with a _PRT that routes to GSIs directly.
+static void gen_host_bridge(struct aml_builder *b, const struct gen_config *config) {
+    aml_begin_device(b, "PCI0");
+    aml_name(b, "_HID");
+    aml_eisaid(b, "PNP0A08");
+    aml_name(b, "_CID");
+    aml_eisaid(b, "PNP0A03");
+    aml_name(b, "_ADR");
+    aml_integer(b, 0);
+    aml_name(b, "_BBN");
+    aml_integer(b, 0);
+    aml_name(b, "_SEG");
+    aml_integer(b, 0);
+    gen_sta(b);
+    aml_begin_method(b, "_UID", 0, 0);
+    aml_return(b);
+    aml_string(b, "PCI0");
+    aml_end(b);
+    aml_name(b, "_CRS");
+    gen_crs(b, 9);
+
+    aml_name(b, "_PRT");
+    aml_begin_package(b, config->prt);
+    for (size_t i = 0; i < config->prt; i++) {
+        aml_begin_package(b, 4);
+        aml_integer(b, ((i / 4) << 16) | 0xFFFF);
+        aml_integer(b, i % 4);
+        aml_integer(b, 0);
+        aml_integer(b, 16 + i);
+        aml_end(b);
+    }
+    aml_end(b);
+    aml_end(b);
+}
+
+// \_SB_.DEVS: a flat scope with many devices.
+static void gen_devices(struct aml_builder *b, const struct gen_config *config) {
+    char name[5];
+
+    aml_begin_device(b, "DEVS");
+    for (size_t i = 0; i < config->devices; i++) {
+        aml_make_nameseg(name, i);
+        aml_begin_device(b, name);
+        aml_name(b, "_ADR");
+        aml_integer(b, i);
+        gen_sta(b);
+        aml_name(b, "_CRS");
+        gen_crs(b, i % 16);
+        aml_end(b);
+    }
+    aml_end(b);
+}
+
+// \_SB_.NEST: a chain of nested devices.
+static void gen_nested(struct aml_builder *b, const struct gen_config *config) {
+    size_t depth = config->depth;
+    if (depth > AML_BUILDER_MAX_DEPTH - 8)
+        depth = AML_BUILDER_MAX_DEPTH - 8;
+
+    aml_begin_device(b, "NEST");
+    for (size_t i = 0; i < depth; i++) {
+        char name[5];
+        aml_make_nameseg(name, i);
+        aml_begin_device(b, name);
+        gen_sta(b);
+    }
+    for (size_t i = 0; i < depth; i++)
+        aml_end(b);
+    aml_end(b);
+}
+
+// \_SB_.FLDS: an operation region with many fields.
+static void gen_fields(struct aml_builder *b, const struct gen_config *config) {
+    char name[5];
+
+    aml_begin_device(b, "FLDS");
+    aml_opregion(b, "REG0", 0 /* SystemMemory */, 0x100000, 4 * config->fields);
+    aml_begin_field(b, "REG0", FIELD_DWORD_ACCESS);
+    for (size_t i = 0; i < config->fields; i++) {
+        aml_make_nameseg(name, i);
+        aml_field_entry(b, name, (i % 2) ? 16 : 32);
+        if (i % 2)
+            aml_field_reserved(b, 16);
+    }
+    aml_end(b);
+    aml_end(b);
+}
+
+// \_SB_.LOOP: While (Local0 < n) { Local0++ }; Return (Local0)
+static void gen_loop(struct aml_builder *b, const struct gen_config *config) {
+    aml_begin_method(b, "LOOP", 0, 0);
+    aml_store(b);
+    aml_integer(b, 0);
+    aml_local(b, 0);
+
+    aml_begin_while(b);
+    aml_lless(b);
+    aml_local(b, 0);
+    aml_integer(b, config->loop);
+    aml_increment(b);
+    aml_local(b, 0);
+    aml_end(b);
+
+    aml_return(b);
+    aml_local(b, 0);
+    aml_end(b);
+}
+
+// \_SB_.CALL: a chain of methods Axxx (Arg0) calling each other.
+// CHN0 () calls the first method of the chain and returns the depth.
+static void gen_calls(struct aml_builder *b, const struct gen_config *config) {
+    char name[5];
+
+    aml_begin_device(b, "CALL");
+    for (size_t i = 0; i < config->calls; i++) {
+        aml_make_nameseg(name, i);
+        aml_begin_method(b, name, 1, 0);
+        aml_return(b);
+        if (i + 1 < config->calls) {
+            aml_make_nameseg(name, i + 1);
+            aml_namestring(b, name);
+            aml_add(b);
+            aml_arg(b, 0);
+            aml_integer(b, 1);
+            aml_null_target(b);
+        } else {
+            aml_arg(b, 0);
+        }
+        aml_end(b);
+    }
+    aml_end(b);
+
+    aml_begin_method(b, "CHN0", 0, 0);
+    aml_return(b);
+    if (config->calls) {
+        aml_make_nameseg(name, 0);
+        char path[11];
+        snprintf(path, sizeof(path), "^CALL.%s", name);
+        aml_namestring(b, path);
+    }
+    aml_integer(b, 1);
+    aml_end(b);
+}
+
+// \_SB_.LOCL: a method that creates Name()s that are torn down when it returns.
+static void gen_locals(struct aml_builder *b, const struct gen_config *config) {
+    char name[5];
+
+    aml_begin_method(b, "LOCL", 0, 0);
+    for (size_t i = 0; i < config->locals; i++) {
+        aml_make_nameseg(name, i);
+        aml_name(b, name);
+        aml_integer(b, i);
+    }
+    aml_return(b);
+    aml_integer(b, config->locals);
+    aml_end(b);
+}
+
+// \_SB_.THRM: a thermal sensor; _TMP is a typical small method that is evaluated often.
+// If (TMPC < CRIT) { Return (TMPC + 0x0AAC) } Else { Return (CRIT) }
+static void gen_thermal(struct aml_builder *b) {
+    aml_begin_device(b, "THRM");
+    aml_name(b, "TMPC");
+    aml_integer(b, 0x0BB8);
+    aml_name(b, "CRIT");
+    aml_integer(b, 0x0E94);
+
+    aml_begin_method(b, "_TMP", 0, 0);
+    aml_begin_if(b);
+    aml_lless(b);
+    aml_namestring(b, "TMPC");
+    aml_namestring(b, "CRIT");
+    aml_return(b);
+    aml_add(b);
+    aml_namestring(b, "TMPC");
+    aml_integer(b, 0x0AAC);
+    aml_null_target(b);
+    aml_end(b);
+    aml_begin_else(b);
+    aml_return(b);
+    aml_namestring(b, "CRIT");
+    aml_end(b);
+    aml_end(b);
+    aml_end(b);
+}
+
+// \_SB_.STRS: a method that builds temporary strings.
+// Local0 = ToHexString (BUF); Local1 = Concat (Local0, Local0); Return (SizeOf (Local1))
+static void gen_strings(struct aml_builder *b) {
+    uint8_t data[32];
+    for (size_t i = 0; i < sizeof(data); i++)
+        data[i] = i;
+
+    aml_name(b, "SBUF");
+    aml_buffer(b, data, sizeof(data));
+
+    aml_begin_method(b, "STRS", 0, 0);
+    aml_store(b);
+    aml_to_hex_string(b);
+    aml_namestring(b, "SBUF");
+    aml_null_target(b);
+    aml_local(b, 0);
+
+    aml_store(b);
+    aml_concat(b);
+    aml_local(b, 0);
+    aml_local(b, 0);
+    aml_null_target(b);
+    aml_local(b, 1);
+
+    aml_return(b);
+    aml_sizeof(b);
+    aml_local(b, 1);
+    aml_end(b);
+}
+
+// \_SB_.RBUF: a method that returns a buffer that it builds (like a typical _CRS).
+// Local0 = Buffer () {...}; Return (Local0)
+static void gen_return_buffer(struct aml_builder *b) {
+    uint8_t data[256];
+    for (size_t i = 0; i < sizeof(data); i++)
+        data[i] = i;
+
+    aml_begin_method(b, "RBUF", 0, 0);
+    aml_store(b);
+    aml_buffer(b, data, sizeof(data));
+    aml_local(b, 0);
+
+    aml_return(b);
+    aml_local(b, 0);
+    aml_end(b);
+}
+
+// \_SB_.BPKG: a large package of integers.
+static void gen_package(struct aml_builder *b, const struct gen_config *config) {
+    aml_name(b, "BPKG");
+    aml_begin_package(b, config->package);
+    for (size_t i = 0; i < config->package; i++)
+        aml_integer(b, i * 0x1001);
+    aml_end(b);
+}
+
+// \_SB_.PCPY: a method that copies \_SB_.BPKG by writing to a copy of it.
+// Local0 = BPKG; Local0[0] = 1; Return (SizeOf (Local0))
+static void gen_package_copy(struct aml_builder *b) {
+    aml_begin_method(b, "PCPY", 0, 0);
+    aml_store(b);
+    aml_namestring(b, "BPKG");
+    aml_local(b, 0);
+
+    aml_store(b);
+    aml_integer(b, 1);
+    aml_index(b);
+    aml_local(b, 0);
+    aml_integer(b, 0);
+    aml_null_target(b);
+
+    aml_return(b);
+    aml_sizeof(b);
+    aml_local(b, 0);
+    aml_end(b);
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: lai-gen [options] -o out.aml\n"
+            "  --ssdt            emit an SSDT instead of a DSDT\n"
+            "  --devices N       number of devices in \\_SB_.DEVS (default 1000)\n"
+            "  --depth N         nesting depth of \\_SB_.NEST (default 16)\n"
+            "  --fields N        number of fields in \\_SB_.FLDS (default 64)\n"
+            "  --package N       number of elements of \\_SB_.BPKG (default 1024)\n"
+            "  --loop N          number of iterations of \\_SB_.LOOP (default 1000)\n"
+            "  --calls N         length of the call chain of \\_SB_.CHN0 (default 32)\n"
+            "  --prt N           number of _PRT entries of \\_SB_.PCI0 (default 32)\n"
+            "  --locals N        number of Name()s created by \\_SB_.LOCL (default 16)\n");
+}
+
+int main(int argc, char **argv) {
+    struct gen_config config = {
+        .signature = "DSDT",
+        .devices = 1000,
+        .depth = 16,
+        .fields = 64,
+        .package = 1024,
+        .loop = 1000,
+        .calls = 32,
+        .prt = 32,
+        .locals = 16,
+    };
+    const char *output = NULL;
+
+    static const struct option options[] = {
+        {"ssdt", no_argument, NULL, 's'},      {"devices", required_argument, NULL, 'd'},
+        {"depth", required_argument, NULL, 'n'}, {"fields", required_argument, NULL, 'f'},
+        {"package", required_argument, NULL, 'p'}, {"loop", required_argument, NULL, 'l'},
+        {"calls", required_argument, NULL, 'c'}, {"prt", required_argument, NULL, 'r'},
+        {"locals", required_argument, NULL, 'm'},
+        {NULL, 0, NULL, 0},
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "o:", options, NULL)) != -1) {
+        switch (opt) {
+            case 'o':
+                output = optarg;
+                break;
+            case 's':
+                config.signature = "SSDT";
+                break;
+            case 'd':
+                config.devices = strtoull(optarg, NULL, 0);
+                break;
+            case 'n':
+                config.depth = strtoull(optarg, NULL, 0);
+                break;
+            case 'f':
+                config.fields = strtoull(optarg, NULL, 0);
+                break;
+            case 'p':
+                config.package = strtoull(optarg, NULL, 0);
+                break;
+            case 'l':
+                config.loop = strtoull(optarg, NULL, 0);
+                break;
+            case 'c':
+                config.calls = strtoull(optarg, NULL, 0);
+                break;
+            case 'r':
+                config.prt = strtoull(optarg, NULL, 0);
+                break;
+            case 'm':
+                config.locals = strtoull(optarg, NULL, 0);
+                break;
+            default:
+                usage();
+                return 1;
+        }
+    }
+    if (!output || optind != argc) {
+        usage();
+        return 1;
+    }
+
+    struct aml_builder b;
+    aml_init(&b, config.signature);
+    aml_begin_scope(&b, "\\_SB_");
+    gen_host_bridge(&b, &config);
+    gen_devices(&b, &config);
+    gen_nested(&b, &config);
+    gen_fields(&b, &config);
+    gen_loop(&b, &config);
+    gen_calls(&b, &config);
+    gen_locals(&b, &config);
+    gen_thermal(&b);
+    gen_strings(&b);
+    gen_return_buffer(&b);
+    gen_package(&b, &config);
+    gen_package_copy(&b);
+    aml_end(&b);
+
+    size_t size;
+    void *table = aml_finish(&b, &size);
+
+    FILE *f = fopen(output, "wb");
+    if (!f || fwrite(table, 1, size, f) != size || fclose(f)) {
+        fprintf(stderr, "lai-gen: could not write %s\n", output);
+        return 1;
+    }
+    free(table);
+    return 0;
+}
@@ -0,0 +1,359 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2021 The lai authors
+ */
+
+/* Userspace laihost implementation used by the benchmarks.
+ * Port I/O, MMIO and PCI configuration space are backed by plain memory,
+ * so AML that touches hardware can run without side effects. */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <lai/core.h>
+#include <lai/host.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "host.h"
+
+// ----------------------------------------------------------------------------
+// Memory allocation.
+// ----------------------------------------------------------------------------
+
+// Every allocation is prefixed by a header that links it into a global list.
+// This allows us to tear down the whole namespace in bench_host_reset_namespace().
+struct bench_block {
+    struct bench_block *prev;
+    struct bench_block *next;
+    size_t size;
+    size_t pad;
+};
+
+static struct bench_block block_list = {&block_list, &block_list, 0, 0};
+static struct bench_alloc_stats stats;
+
+static void bench_link_block(struct bench_block *block) {
+    block->next = &block_list;
+    block->prev = block_list.prev;
+    block_list.prev->next = block;
+    block_list.prev = block;
+}
+
+static void bench_unlink_block(struct bench_block *block) {
+    block->prev->next = block->next;
+    block->next->prev = block->prev;
+}
+
+void *laihost_malloc(size_t size) {
+    struct bench_block *block = malloc(sizeof(struct bench_block) + size);
+    if (!block)
+        return NULL;
+    block->size = size;
+    bench_link_block(block);
+
+    stats.allocs++;
+    stats.bytes += size;
+    stats.live_bytes += size;
+    if (stats.live_bytes > stats.peak_bytes)
+        stats.peak_bytes = stats.live_bytes;
+    return block + 1;
+}
+
+void *laihost_realloc(void *ptr, size_t newsize, size_t oldsize) {
+    if (!ptr)
+        return laihost_malloc(newsize);
+
+    struct bench_block *block = (struct bench_block *)ptr - 1;
+    if (block->size != oldsize) {
+        fprintf(stderr, "lai-bench: laihost_realloc() with wrong size %zu (expected %zu)\n",
+                oldsize, block->size);
+        abort();
+    }
+
+    bench_unlink_block(block);
+    struct bench_block *new_block = realloc(block, sizeof(struct bench_block) + newsize);
+    if (!new_block) {
+        bench_link_block(block);
+        return NULL;
+    }
+    new_block->size = newsize;
+    bench_link_block(new_block);
+
+    stats.allocs++;
+    stats.bytes += newsize;
+    stats.live_bytes += newsize - oldsize;
+    if (stats.live_bytes > stats.peak_bytes)
+        stats.peak_bytes = stats.live_bytes;
+    return new_block + 1;
+}
+
+void laihost_free(void *ptr, size_t size) {
+    if (!ptr)
+        return;
+
+    struct bench_block *block = (struct bench_block *)ptr - 1;
+    if (size && block->size != size) {
+        fprintf(stderr, "lai-bench: laihost_free() with wrong size %zu (expected %zu)\n", size,
+                block->size);
+        abort();
+    }
+
+    stats.frees++;
+    stats.live_bytes -= block->size;
+    bench_unlink_block(block);
+    free(block);
+}
+
+void bench_host_get_stats(struct bench_alloc_stats *out) {
+    *out = stats;
+}
+
+void bench_host_reset_namespace(void) {
+    while (block_list.next != &block_list) {
+        struct bench_block *block = block_list.next;
+        stats.live_bytes -= block->size;
+        bench_unlink_block(block);
+        free(block);
+    }
+
+    struct lai_instance *instance = lai_current_instance();
+    int acpi_revision = instance->acpi_revision;
+    int trace = instance->trace;
+    memset(instance, 0, sizeof(struct lai_instance));
+    instance->acpi_revision = acpi_revision;
+    instance->trace = trace;
+}
+
+// ----------------------------------------------------------------------------
+// Logging.
+// ----------------------------------------------------------------------------
+
+static int verbose;
+
+void bench_host_set_verbose(int v) {
+    verbose = v;
+}
+
+void laihost_log(int level, const char *msg) {
+    if (level == LAI_DEBUG_LOG && !verbose)
+        return;
+    fprintf(stderr, "lai %s: %s\n", (level == LAI_DEBUG_LOG) ? "debug" : "warning", msg);
+}
+
+void laihost_panic(const char *msg) {
+    fprintf(stderr, "lai panic: %s\n", msg);
+    abort();
+}
+
+// ----------------------------------------------------------------------------
+// ACPI tables.
+// ----------------------------------------------------------------------------
+
+#define BENCH_MAX_TABLES 64
+
+static acpi_header_t *tables[BENCH_MAX_TABLES];
+static size_t num_tables;
+
+int bench_host_add_table(const void *table, size_t size) {
+    if (num_tables == BENCH_MAX_TABLES || size < sizeof(acpi_header_t))
+        return -1;
+
+    const acpi_header_t *header = table;
+    if (header->length > size)
+        return -1;
+
+    acpi_header_t *copy = malloc(size);
+    if (!copy)
+        return -1;
+    memcpy(copy, table, size);
+    tables[num_tables++] = copy;
+    return 0;
+}
+
+int bench_host_load_table(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return -1;
+
+    int ret = -1;
+    void *data = NULL;
+    if (fseek(f, 0, SEEK_END))
+        goto done;
+    long size = ftell(f);
+    if (size < 0 || fseek(f, 0, SEEK_SET))
+        goto done;
+
+    data = malloc(size ? size : 1);
+    if (!data || fread(data, 1, size, f) != (size_t)size)
+        goto done;
+    ret = bench_host_add_table(data, size);
+
+done:
+    free(data);
+    fclose(f);
+    return ret;
+}
+
+void bench_host_ensure_fadt(void) {
+    for (size_t i = 0; i < num_tables; i++) {
+        if (!memcmp(tables[i]->signature, "FACP", 4))
+            return;
+    }
+
+    // An empty FADT: no fixed hardware is described.
+    acpi_fadt_t fadt;
+    memset(&fadt, 0, sizeof(acpi_fadt_t));
+    memcpy(fadt.header.signature, "FACP", 4);
+    fadt.header.length = sizeof(acpi_fadt_t);
+    fadt.header.revision = 6;
+    memcpy(fadt.header.oem, "LAI   ", 6);
+    memcpy(fadt.header.oem_table, "LAIBENCH", 8);
+
+    uint8_t sum = 0;
+    for (size_t i = 0; i < sizeof(acpi_fadt_t); i++)
+        sum += ((uint8_t *)&fadt)[i];
+    fadt.header.checksum = -sum;
+
+    bench_host_add_table(&fadt, sizeof(acpi_fadt_t));
+}
+
+void *laihost_scan(const char *sig, size_t index) {
+    for (size_t i = 0; i < num_tables; i++) {
+        if (memcmp(tables[i]->signature, sig, 4))
+            continue;
+        if (!index)
+            return tables[i];
+        index--;
+    }
+    return NULL;
+}
+
+// ----------------------------------------------------------------------------
+// Virtual hardware: port I/O, MMIO and PCI configuration space.
+// ----------------------------------------------------------------------------
+
+static uint8_t port_space[0x10000 + 4];
+
+void laihost_outb(uint16_t port, uint8_t value) {
+    port_space[port] = value;
+}
+
+void laihost_outw(uint16_t port, uint16_t value) {
+    memcpy(&port_space[port], &value, sizeof(uint16_t));
+}
+
+void laihost_outd(uint16_t port, uint32_t value) {
+    memcpy(&port_space[port], &value, sizeof(uint32_t));
+}
+
+uint8_t laihost_inb(uint16_t port) {
+    return port_space[port];
+}
+
+uint16_t laihost_inw(uint16_t port) {
+    uint16_t value;
+    memcpy(&value, &port_space[port], sizeof(uint16_t));
+    return value;
+}
+
+uint32_t laihost_ind(uint16_t port) {
+    uint32_t value;
+    memcpy(&value, &port_space[port], sizeof(uint32_t));
+    return value;
+}
+
+// MMIO mappings are backed by zero-initialized memory. Mappings of the same
+// physical address share the same backing memory.
+struct bench_mapping {
+    struct bench_mapping *next;
+    size_t address;
+    size_t size;
+    uint8_t *memory;
+};
+
+static struct bench_mapping *mappings;
+
+void *laihost_map(size_t address, size_t size) {
+    for (struct bench_mapping *m = mappings; m; m = m->next) {
+        if (address >= m->address && address + size <= m->address + m->size)
+            return m->memory + (address - m->address);
+    }
+
+    struct bench_mapping *m = malloc(sizeof(struct bench_mapping));
+    if (!m)
+        laihost_panic("could not allocate MMIO mapping");
+    m->address = address;
+    m->size = size;
+    m->memory = calloc(1, size ? size : 1);
+    if (!m->memory)
+        laihost_panic("could not allocate MMIO mapping");
+    m->next = mappings;
+    mappings = m;
+    return m->memory;
+}
+
+void laihost_unmap(void *pointer, size_t count) {
+    // Mappings are kept alive, such that their contents persist.
+    (void)pointer;
+    (void)count;
+}
+
+// Legacy configuration space of segment 0; other accesses read as all ones.
+#define BENCH_PCI_FUNCTIONS (256 * 32 * 8)
+
+static uint8_t (*pci_space)[256];
+
+static uint8_t *bench_pci_address(uint16_t seg, uint8_t bus, uint8_t slot, uint8_t fun,
+                                  uint16_t offset, size_t width) {
+    if (seg || slot >= 32 || fun >= 8 || offset + width > 256)
+        return NULL;
+    if (!pci_space) {
+        pci_space = calloc(BENCH_PCI_FUNCTIONS, 256);
+        if (!pci_space)
+            laihost_panic("could not allocate PCI configuration space");
+    }
+    return &pci_space[(bus * 32 + slot) * 8 + fun][offset];
+}
+
+#define BENCH_PCI_ACCESSORS(suffix, type)                                                          \
+    void laihost_pci_write##suffix(uint16_t seg, uint8_t bus, uint8_t slot, uint8_t fun,           \
+                                   uint16_t offset, type value) {                                  \
+        uint8_t *p = bench_pci_address(seg, bus, slot, fun, offset, sizeof(type));                 \
+        if (p)                                                                                     \
+            memcpy(p, &value, sizeof(type));                                                       \
+    }                                                                                              \
+    type laihost_pci_read##suffix(uint16_t seg, uint8_t bus, uint8_t slot, uint8_t fun,            \
+                                  uint16_t offset) {                                               \
+        type value = (type)~0;                                                                     \
+        uint8_t *p = bench_pci_address(seg, bus, slot, fun, offset, sizeof(type));                 \
+        if (p)                                                                                     \
+            memcpy(&value, p, sizeof(type));                                                       \
+        return value;                                                                              \
+    }
+
+BENCH_PCI_ACCESSORS(b, uint8_t)
+BENCH_PCI_ACCESSORS(w, uint16_t)
+BENCH_PCI_ACCESSORS(d, uint32_t)
+
+// ----------------------------------------------------------------------------
+// Timers.
+// ----------------------------------------------------------------------------
+
+uint64_t bench_host_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void laihost_sleep(uint64_t ms) {
+    // Sleeping would only distort the measurements.
+    (void)ms;
+}
+
+uint64_t laihost_timer(void) {
+    // LAI expects 100ns units.
+    return bench_host_now_ns() / 100;
+}
@@ -0,0 +1,48 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2021 The lai authors
+ */
+
+/* Userspace laihost implementation used by the benchmarks. */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct bench_alloc_stats {
+    uint64_t allocs;   // Number of laihost_malloc() calls (and reallocs that move memory).
+    uint64_t frees;    // Number of laihost_free() calls.
+    uint64_t bytes;    // Total number of bytes requested.
+    size_t live_bytes; // Bytes that are currently allocated.
+    size_t peak_bytes; // High watermark of live_bytes.
+};
+
+// Reads an ACPI table from a file and makes it available to laihost_scan().
+// Returns 0 on success.
+int bench_host_load_table(const char *path);
+
+// Makes an in-memory table available to laihost_scan(). The table is copied.
+int bench_host_add_table(const void *table, size_t size);
+
+// Synthesizes a FADT if none of the loaded tables is a FADT.
+void bench_host_ensure_fadt(void);
+
+void bench_host_get_stats(struct bench_alloc_stats *stats);
+
+// Frees all memory that LAI allocated through laihost_malloc() and resets the
+// global LAI instance. This allows lai_create_namespace() to be run repeatedly.
+void bench_host_reset_namespace(void);
+
+// Enables laihost_log() output on stderr.
+void bench_host_set_verbose(int verbose);
+
+uint64_t bench_host_now_ns(void);
+
+#ifdef __cplusplus
+}
+#endif
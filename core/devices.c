@@ -0,0 +1,254 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2021 The lai authors
+ */
+
+/* Device enumeration.
+ * Finding all devices with a given PNP ID would require evaluating _HID and _CID of every
+ * device in the namespace. Instead, the results of these evaluations are collected into an
+ * index that is sorted by ID. The index is built on first use and rebuilt whenever the
+ * set of devices or their IDs change (i.e., if device_generation does not match). */
+
+#include <lai/core.h>
+
+#include "exec_impl.h"
+#include "libc.h"
+#include "ns_impl.h"
+
+static uint32_t lai_device_id_hash(const char *string) {
+    // FNV-1a.
+    uint32_t hash = 2166136261;
+    for (; *string; string++) {
+        hash ^= (uint8_t)*string;
+        hash *= 16777619;
+    }
+    return hash;
+}
+
+// Computes the key of an ID. Returns zero on success.
+// For string IDs that are not in EISA format, *string is set to the string.
+static int lai_device_id_key(lai_variable_t *id, uint64_t *key, const char **string) {
+    *string = NULL;
+    if (id->type == LAI_INTEGER) {
+        if (id->integer & LAI_DEVICE_ID_STRING)
+            return 1;
+        *key = id->integer;
+        return 0;
+    } else if (id->type == LAI_STRING) {
+        const char *s = lai_exec_string_access(id);
+        if (lai_strlen(s) == 7) {
+            // Match EISA IDs that firmware reports as strings against integer EISA IDs.
+            LAI_CLEANUP_VAR lai_variable_t eisaid = LAI_VAR_INITIALIZER;
+            lai_eisaid(&eisaid, s);
+            *key = eisaid.integer;
+            return 0;
+        }
+        *key = LAI_DEVICE_ID_STRING | lai_device_id_hash(s);
+        *string = s;
+        return 0;
+    }
+    return 1;
+}
+
+static int lai_device_id_compare(uint64_t key_a, const char *string_a, uint64_t key_b,
+                                 const char *string_b) {
+    if (key_a != key_b)
+        return key_a < key_b ? -1 : 1;
+    if (!(key_a & LAI_DEVICE_ID_STRING))
+        return 0;
+    return lai_strcmp(string_a, string_b);
+}
+
+static inline const char *lai_device_id_string(struct lai_device_index *index,
+                                               struct lai_device_id *id) {
+    if (!(id->key & LAI_DEVICE_ID_STRING))
+        return NULL;
+    return index->strings + id->string;
+}
+
+static void *lai_device_index_grow(void *array, size_t *capacity, size_t elem_size,
+                                   size_t needed) {
+    if (needed <= *capacity)
+        return array;
+    size_t new_capacity = *capacity ? *capacity : 32;
+    while (new_capacity < needed)
+        new_capacity *= 2;
+    void *new_array = laihost_realloc(array, new_capacity * elem_size, *capacity * elem_size);
+    if (!new_array)
+        lai_panic("could not reallocate device index");
+    *capacity = new_capacity;
+    return new_array;
+}
+
+static void lai_device_index_add_id(struct lai_device_index *index, lai_nsnode_t *node,
+                                    lai_variable_t *id) {
+    uint64_t key;
+    const char *string;
+    if (lai_device_id_key(id, &key, &string))
+        return;
+
+    // _HID and _CID may report the same ID; the IDs of the current device are at the end.
+    for (size_t i = index->num_ids; i > 0 && index->ids[i - 1].node == node; i--) {
+        struct lai_device_id *other = &index->ids[i - 1];
+        if (!lai_device_id_compare(key, string, other->key, lai_device_id_string(index, other)))
+            return;
+    }
+
+    uint32_t offset = 0;
+    if (string) {
+        size_t length = lai_strlen(string) + 1;
+        index->strings = lai_device_index_grow(index->strings, &index->strings_capacity, 1,
+                                               index->strings_size + length);
+        offset = index->strings_size;
+        memcpy(index->strings + offset, string, length);
+        index->strings_size += length;
+    }
+
+    index->ids = lai_device_index_grow(index->ids, &index->ids_capacity,
+                                       sizeof(struct lai_device_id), index->num_ids + 1);
+    index->ids[index->num_ids++] = (struct lai_device_id){key, offset, node};
+}
+
+static void lai_device_index_add_object(struct lai_device_index *index, lai_nsnode_t *node,
+                                        const char *name, lai_state_t *state) {
+    lai_nsnode_t *handle = lai_resolve_path(node, name);
+    if (!handle)
+        return;
+
+    LAI_CLEANUP_VAR lai_variable_t id = LAI_VAR_INITIALIZER;
+    if (lai_eval(&id, handle, state)) {
+        lai_warn("could not evaluate %s of device", name);
+        return;
+    }
+
+    // _CID can return a package of IDs.
+    struct lai_pkg_view ids;
+    if (lai_obj_view_pkg(&id, &ids)) {
+        lai_device_index_add_id(index, node, &id);
+        return;
+    }
+
+    for (size_t i = 0; i < ids.size; i++)
+        lai_device_index_add_id(index, node, &ids.elems[i]);
+}
+
+// Stable merge sort, such that devices with the same ID stay in definition order.
+static void lai_device_index_sort(struct lai_device_index *index) {
+    size_t n = index->num_ids;
+    if (n < 2)
+        return;
+
+    struct lai_device_id *temp = laihost_malloc(n * sizeof(struct lai_device_id));
+    if (!temp)
+        lai_panic("could not allocate memory for device index");
+
+    struct lai_device_id *src = index->ids;
+    struct lai_device_id *dst = temp;
+    for (size_t width = 1; width < n; width *= 2) {
+        for (size_t lo = 0; lo < n; lo += 2 * width) {
+            size_t mid = (lo + width < n) ? lo + width : n;
+            size_t hi = (lo + 2 * width < n) ? lo + 2 * width : n;
+            size_t i = lo, j = mid, k = lo;
+            while (i < mid && j < hi) {
+                if (lai_device_id_compare(src[j].key, lai_device_id_string(index, &src[j]),
+                                          src[i].key, lai_device_id_string(index, &src[i]))
+                    < 0)
+                    dst[k++] = src[j++];
+                else
+                    dst[k++] = src[i++];
+            }
+            while (i < mid)
+                dst[k++] = src[i++];
+            while (j < hi)
+                dst[k++] = src[j++];
+        }
+        struct lai_device_id *swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    if (src != index->ids)
+        memcpy(index->ids, src, n * sizeof(struct lai_device_id));
+    laihost_free(temp, n * sizeof(struct lai_device_id));
+}
+
+static void lai_device_index_build(struct lai_device_index *index) {
+    index->num_devices = 0;
+    index->num_ids = 0;
+    index->strings_size = 0;
+
+    LAI_CLEANUP_STATE lai_state_t state;
+    lai_init_state(&state);
+
+    lai_nsnode_t *root = lai_ns_get_root();
+    lai_nsnode_t *node = root;
+    while ((node = lai_ns_preorder_next(root, node))) {
+        if (node->type != LAI_NAMESPACE_DEVICE)
+            continue;
+
+        index->devices = lai_device_index_grow(index->devices, &index->devices_capacity,
+                                               sizeof(lai_nsnode_t *), index->num_devices + 1);
+        index->devices[index->num_devices++] = node;
+
+        lai_device_index_add_object(index, node, "_HID", &state);
+        lai_device_index_add_object(index, node, "_CID", &state);
+    }
+
+    lai_device_index_sort(index);
+
+    // _HID and _CID methods may create (and destroy) temporary nodes; hence, take the
+    // generation after evaluating them.
+    index->generation = lai_current_instance()->device_generation;
+}
+
+static struct lai_device_index *lai_get_device_index(void) {
+    struct lai_instance *instance = lai_current_instance();
+    if (!instance->device_index) {
+        instance->device_index = laihost_malloc(sizeof(struct lai_device_index));
+        if (!instance->device_index)
+            lai_panic("could not allocate memory for device index");
+        memset(instance->device_index, 0, sizeof(struct lai_device_index));
+        lai_device_index_build(instance->device_index);
+    } else if (instance->device_index->generation != instance->device_generation) {
+        lai_device_index_build(instance->device_index);
+    }
+    return instance->device_index;
+}
+
+lai_nsnode_t *lai_get_device(size_t n) {
+    struct lai_device_index *index = lai_get_device_index();
+    if (n >= index->num_devices)
+        return NULL;
+    return index->devices[n];
+}
+
+lai_nsnode_t *lai_enum(char *id, size_t n) {
+    LAI_CLEANUP_VAR lai_variable_t id_var = LAI_VAR_INITIALIZER;
+    lai_eisaid(&id_var, id);
+
+    uint64_t key;
+    const char *string;
+    if (lai_device_id_key(&id_var, &key, &string))
+        return NULL;
+
+    struct lai_device_index *index = lai_get_device_index();
+
+    // Find the first entry with the given ID.
+    size_t lo = 0, hi = index->num_ids;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        struct lai_device_id *entry = &index->ids[mid];
+        if (lai_device_id_compare(entry->key, lai_device_id_string(index, entry), key, string)
+            < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (n >= index->num_ids - lo)
+        return NULL;
+    struct lai_device_id *entry = &index->ids[lo + n];
+    if (lai_device_id_compare(entry->key, lai_device_id_string(index, entry), key, string))
+        return NULL;
+    return entry->node;
+}
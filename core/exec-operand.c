@@ -17,11 +17,22 @@ size_t lai_exec_string_length(lai_variable_t *str) {
 
 // Note: This function exists to enable better GC and proper locking in the future.
 void lai_exec_pkg_var_load(lai_variable_t *out, struct lai_pkg_head *head, size_t i) {
+    // The interpreter can mutate the element through the result (e.g., via Index()).
+    // Thus, strings, buffers and packages must not be shared with clones of the package.
+    switch (head->elems[i].type) {
+        case LAI_STRING:
+        case LAI_BUFFER:
+        case LAI_PACKAGE:
+            lai_exec_unshare_pkg(head);
+    }
     lai_var_assign(out, &head->elems[i]);
 }
 
 // Note: This function exists to enable better GC and proper locking in the future.
 void lai_exec_pkg_var_store(lai_variable_t *in, struct lai_pkg_head *head, size_t i) {
+    lai_exec_unshare_pkg(head);
+    // The package might outlive the evaluation.
+    lai_exec_promote(in);
     lai_var_assign(&head->elems[i], in);
 }
 
@@ -36,10 +47,10 @@ void lai_exec_ref_load(lai_variable_t *object, lai_variable_t *ref) {
     // Note: This function intentionally *does not* handle indices.
     switch (ref->type) {
         case LAI_ARG_REF:
-            lai_var_assign(object, &ref->iref_invocation->arg[ref->iref_index]);
+            lai_var_assign(object, &ref->iref_invocation->arg[ref->index]);
             break;
         case LAI_LOCAL_REF:
-            lai_var_assign(object, &ref->iref_invocation->local[ref->iref_index]);
+            lai_var_assign(object, &ref->iref_invocation->local[ref->index]);
             break;
         case LAI_NODE_REF:
             lai_exec_access(object, ref->handle);
@@ -53,10 +64,10 @@ void lai_exec_ref_store(lai_variable_t *ref, lai_variable_t *object) {
     // Note: This function intentionally *does not* handle indices.
     switch (ref->type) {
         case LAI_ARG_REF:
-            lai_var_assign(&ref->iref_invocation->arg[ref->iref_index], object);
+            lai_var_assign(&ref->iref_invocation->arg[ref->index], object);
             break;
         case LAI_LOCAL_REF:
-            lai_var_assign(&ref->iref_invocation->local[ref->iref_index], object);
+            lai_var_assign(&ref->iref_invocation->local[ref->index], object);
             break;
         case LAI_NODE_REF:
             lai_store_ns(ref->handle, object);
@@ -134,6 +145,7 @@ void lai_operand_load(lai_state_t *state, struct lai_operand *src, lai_variable_
 void lai_store_ns(lai_nsnode_t *target, lai_variable_t *object) {
     switch (target->type) {
         case LAI_NAMESPACE_NAME:
+            lai_exec_promote(object);
             lai_var_assign(&target->object, object);
             break;
         case LAI_NAMESPACE_FIELD:
@@ -171,13 +183,14 @@ void lai_exec_mutate_ns(lai_nsnode_t *target, lai_variable_t *object) {
                     if (lai_obj_resize_pkg(&target->object, n))
                         lai_panic("could not resize package in lai_exec_mutate_ns()");
                     for (size_t i = 0; i < n; i++) {
-                        lai_variable_t temp = LAI_VAR_INITIALIZER;
-                        lai_exec_pkg_load(&temp, object, i);
+                        LAI_CLEANUP_VAR lai_variable_t temp = LAI_VAR_INITIALIZER;
+                        lai_obj_clone(&temp, &object->pkg_ptr->elems[i]);
                         lai_exec_pkg_store(&temp, &target->object, i);
                     }
                     break;
                 }
                 default:
+                    lai_exec_promote(object);
                     lai_var_assign(&target->object, object);
             }
             break;
@@ -200,19 +213,21 @@ void lai_operand_mutate(lai_state_t *state, struct lai_operand *dest, lai_variab
     if (dest->tag == LAI_OPERAND_OBJECT) {
         switch (dest->object.type) {
             case LAI_STRING_INDEX: {
+                lai_exec_unshare_string(dest->object.string_ptr);
                 char *window = dest->object.string_ptr->content;
-                window[dest->object.integer] = object->integer;
+                window[dest->object.index] = object->integer;
                 break;
             }
             case LAI_BUFFER_INDEX: {
+                lai_exec_unshare_buffer(dest->object.buffer_ptr);
                 uint8_t *window = dest->object.buffer_ptr->content;
-                window[dest->object.integer] = object->integer;
+                window[dest->object.index] = object->integer;
                 break;
             }
             case LAI_PACKAGE_INDEX: {
                 lai_variable_t copy = {0};
                 lai_var_assign(&copy, object);
-                lai_exec_pkg_var_store(&copy, dest->object.pkg_ptr, dest->object.integer);
+                lai_exec_pkg_var_store(&copy, dest->object.pkg_ptr, dest->object.index);
                 lai_var_finalize(&copy);
                 break;
             }
@@ -284,19 +299,21 @@ void lai_operand_emplace(lai_state_t *state, struct lai_operand *dest, lai_varia
     if (dest->tag == LAI_OPERAND_OBJECT) {
         switch (dest->object.type) {
             case LAI_STRING_INDEX: {
+                lai_exec_unshare_string(dest->object.string_ptr);
                 char *window = dest->object.string_ptr->content;
-                window[dest->object.integer] = object->integer;
+                window[dest->object.index] = object->integer;
                 break;
             }
             case LAI_BUFFER_INDEX: {
+                lai_exec_unshare_buffer(dest->object.buffer_ptr);
                 uint8_t *window = dest->object.buffer_ptr->content;
-                window[dest->object.integer] = object->integer;
+                window[dest->object.index] = object->integer;
                 break;
             }
             case LAI_PACKAGE_INDEX: {
                 lai_variable_t copy = {0};
                 lai_var_assign(&copy, object);
-                lai_exec_pkg_var_store(&copy, dest->object.pkg_ptr, dest->object.integer);
+                lai_exec_pkg_var_store(&copy, dest->object.pkg_ptr, dest->object.index);
                 lai_var_finalize(&copy);
                 break;
             }
@@ -390,6 +407,7 @@ static void lai_write_buffer(lai_nsnode_t *handle, lai_variable_t *source) {
     // Offset that we are writing to, in bytes.
     size_t offset = handle->bf_offset;
     size_t size = handle->bf_size;
+    lai_exec_unshare_buffer(handle->bf_buffer);
     uint8_t *data = handle->bf_buffer->content;
 
     size_t n = 0; // Number of bits that have been written.
@@ -10,12 +10,12 @@
 #include "exec_impl.h"
 #include "libc.h"
 #include "ns_impl.h"
+#include "slab.h"
 #include "util-list.h"
 #include "util-macros.h"
 
 static int debug_stack = 0;
 
-static lai_api_error_t lai_exec_process(lai_state_t *state);
 static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state);
 
 // Prepare the interpreter state for a control method call.
@@ -35,10 +35,92 @@ void lai_init_state(lai_state_t *state) {
     state->ctxstack_ptr = -1;
     state->blkstack_ptr = -1;
     state->stack_ptr = -1;
+    for (int i = LAI_SMALL_INVOCATIONS - 1; i >= 0; i--) {
+        state->small_invocations[i].next_free = state->free_invocations;
+        state->free_invocations = &state->small_invocations[i];
+    }
 }
 
-// Finalize the interpreter state. Frees all memory owned by the state.
-void lai_finalize_state(lai_state_t *state) {
+// Objects that are larger than this are not allocated from the arena.
+#define LAI_ARENA_MAX_OBJECT 1024
+#define LAI_ARENA_CHUNK_SIZE 4096
+// Once the arena reaches this size, further temporaries are allocated from the heap.
+#define LAI_ARENA_MAX_SIZE (16 * LAI_ARENA_CHUNK_SIZE)
+
+static inline size_t lai_exec_arena_start(void) {
+    return (sizeof(struct lai_arena_chunk) + LAI_ARENA_ALIGN - 1)
+           & ~(size_t)(LAI_ARENA_ALIGN - 1);
+}
+
+void *lai_exec_arena_alloc(lai_state_t *state, size_t size) {
+    if (size > LAI_ARENA_MAX_OBJECT)
+        return NULL;
+    size = (size + LAI_ARENA_ALIGN - 1) & ~(size_t)(LAI_ARENA_ALIGN - 1);
+    size += LAI_ARENA_ALIGN; // Pointer to the chunk.
+
+    struct lai_arena_chunk *chunk = state->arena;
+    if (!chunk || size > chunk->size - chunk->used) {
+        if (state->arena_size + LAI_ARENA_CHUNK_SIZE > LAI_ARENA_MAX_SIZE)
+            return NULL;
+        chunk = laihost_malloc(LAI_ARENA_CHUNK_SIZE);
+        if (!chunk)
+            return NULL;
+        chunk->next = state->arena;
+        chunk->size = LAI_ARENA_CHUNK_SIZE;
+        chunk->used = lai_exec_arena_start();
+        chunk->live = 0;
+        state->arena = chunk;
+        state->arena_size += LAI_ARENA_CHUNK_SIZE;
+    }
+
+    uint8_t *ptr = (uint8_t *)chunk + chunk->used;
+    chunk->used += size;
+    chunk->live++;
+    *(struct lai_arena_chunk **)ptr = chunk;
+    return ptr + LAI_ARENA_ALIGN;
+}
+
+// Frees the chunks of the arena whose objects are all released.
+// The first chunk is kept (and rewound) for the next allocations.
+static void lai_exec_trim_arena(lai_state_t *state) {
+    struct lai_arena_chunk *chunk = state->arena;
+    if (!chunk)
+        return;
+    if (!chunk->live)
+        chunk->used = lai_exec_arena_start();
+
+    struct lai_arena_chunk **link = &chunk->next;
+    while (*link) {
+        struct lai_arena_chunk *unused = *link;
+        if (unused->live) {
+            link = &unused->next;
+            continue;
+        }
+        *link = unused->next;
+        state->arena_size -= unused->size;
+        laihost_free(unused, unused->size);
+    }
+}
+
+// Frees all objects in the arena. Keeps one chunk for the next evaluation.
+static void lai_exec_reset_arena(lai_state_t *state) {
+    struct lai_arena_chunk *chunk = state->arena;
+    if (!chunk)
+        return;
+    struct lai_arena_chunk *next = chunk->next;
+    while (next) {
+        struct lai_arena_chunk *unused = next;
+        next = next->next;
+        laihost_free(unused, unused->size);
+    }
+    chunk->next = NULL;
+    chunk->used = lai_exec_arena_start();
+    chunk->live = 0;
+    state->arena_size = chunk->size;
+}
+
+// Pops all items from all stacks but keeps the memory of the stacks.
+static void lai_exec_clear_state(lai_state_t *state) {
     while (state->ctxstack_ptr >= 0)
         lai_exec_pop_ctxstack_back(state);
     while (state->blkstack_ptr >= 0)
@@ -46,6 +128,22 @@ void lai_finalize_state(lai_state_t *state) {
     while (state->stack_ptr >= 0)
         lai_exec_pop_stack_back(state);
     lai_exec_pop_opstack(state, state->opstack_ptr);
+    lai_exec_reset_arena(state);
+}
+
+// Finalize the interpreter state. Frees all memory owned by the state.
+void lai_finalize_state(lai_state_t *state) {
+    lai_exec_clear_state(state);
+
+    struct lai_invocation *invocation = state->free_invocations;
+    while (invocation) {
+        struct lai_invocation *next = invocation->next_free;
+        if (invocation < state->small_invocations
+            || invocation >= state->small_invocations + LAI_SMALL_INVOCATIONS)
+            lai_slab_free(LAI_SLAB_INVOCATION, invocation);
+        invocation = next;
+    }
+    state->free_invocations = NULL;
 
     if (state->ctxstack_base != state->small_ctxstack)
         laihost_free(state->ctxstack_base, state->ctxstack_capacity * sizeof(struct lai_ctxitem));
@@ -55,6 +153,52 @@ void lai_finalize_state(lai_state_t *state) {
         laihost_free(state->stack_base, state->stack_capacity * sizeof(lai_stackitem_t));
     if (state->opstack_base != state->small_opstack)
         laihost_free(state->opstack_base, state->opstack_capacity * sizeof(struct lai_operand));
+    if (state->arena) {
+        laihost_free(state->arena, state->arena->size);
+        state->arena = NULL;
+        state->arena_size = 0;
+    }
+}
+
+// States that are released by lai_release_state() are cached in the instance and handed out
+// again by lai_acquire_state(). Cached states are already cleared and keep their grown stacks
+// and invocation frames. If the host implements laihost_current_cpu(), each CPU uses its own
+// LAI_STATE_POOL_WAYS slots (helpers that evaluate objects while holding a state need more
+// than one). Slots are accessed atomically; concurrent users of the same slots only miss the
+// cache.
+static lai_state_t **lai_state_pool_slots(void) {
+    unsigned int cpu = laihost_current_cpu ? laihost_current_cpu() : 0;
+    size_t num_sets = LAI_STATE_POOL_SIZE / LAI_STATE_POOL_WAYS;
+    return &lai_current_instance()->state_pool[(cpu % num_sets) * LAI_STATE_POOL_WAYS];
+}
+
+lai_state_t *lai_acquire_state(void) {
+    lai_state_t **slots = lai_state_pool_slots();
+    for (int i = 0; i < LAI_STATE_POOL_WAYS; i++) {
+        lai_state_t *state = __atomic_exchange_n(&slots[i], NULL, __ATOMIC_ACQUIRE);
+        if (state)
+            return state;
+    }
+
+    lai_state_t *state = laihost_malloc(sizeof(lai_state_t));
+    if (!state)
+        lai_panic("could not allocate memory for interpreter state");
+    lai_init_state(state);
+    return state;
+}
+
+void lai_release_state(lai_state_t *state) {
+    lai_exec_clear_state(state);
+
+    lai_state_t **slots = lai_state_pool_slots();
+    for (int i = 0; i < LAI_STATE_POOL_WAYS; i++) {
+        lai_state_t *expected = NULL;
+        if (__atomic_compare_exchange_n(&slots[i], &expected, state, 0, __ATOMIC_RELEASE,
+                                        __ATOMIC_RELAXED))
+            return;
+    }
+    lai_finalize_state(state);
+    laihost_free(state, sizeof(lai_state_t));
 }
 
 static void lai_exec_reduce_node(int opcode, lai_state_t *state, struct lai_operand *operands,
@@ -73,6 +217,7 @@ static void lai_exec_reduce_node(int opcode, lai_state_t *state, struct lai_oper
             lai_nsnode_t *node = lai_create_nsnode_or_die();
             node->type = LAI_NAMESPACE_NAME;
             lai_do_resolve_new_node(node, ctx_handle, &amln);
+            lai_exec_promote(&object);
             lai_var_move(&node->object, &object);
             lai_install_nsnode(node);
             struct lai_ctxitem *ctxitem = lai_exec_peek_ctxstack_back(state);
@@ -98,6 +243,7 @@ static void lai_exec_reduce_node(int opcode, lai_state_t *state, struct lai_oper
 
             LAI_CLEANUP_VAR lai_variable_t buf = LAI_VAR_INITIALIZER;
             lai_operand_load(state, &operands[0], &buf);
+            lai_exec_promote(&buf);
             node->bf_buffer = buf.buffer_ptr;
             lai_rc_ref(&node->bf_buffer->rc);
 
@@ -152,6 +298,7 @@ static void lai_exec_reduce_node(int opcode, lai_state_t *state, struct lai_oper
 
             LAI_CLEANUP_VAR lai_variable_t buf = LAI_VAR_INITIALIZER;
             lai_operand_load(state, &operands[0], &buf);
+            lai_exec_promote(&buf);
             node->bf_buffer = buf.buffer_ptr;
             lai_rc_ref(&node->bf_buffer->rc);
 
@@ -318,7 +465,8 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
             if (operand1.type != LAI_INTEGER && operand1.type != LAI_BUFFER
                 && operand1.type != LAI_STRING) {
                 if (operand1.type == LAI_HANDLE) {
-                    lai_api_error_t error = lai_create_string(&operand1_convert_temp, 0);
+                    lai_api_error_t error
+                        = lai_exec_create_string(state, &operand1_convert_temp, 0);
                     if (error != LAI_ERROR_NONE) {
                         lai_warn("failed to allocate memory for AML string");
                         return error;
@@ -330,7 +478,8 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
                         return error;
                     }
                 } else if (operand1.type == LAI_TYPE_NONE) {
-                    lai_api_error_t error = lai_create_string(&operand1_convert_temp, 22);
+                    lai_api_error_t error
+                        = lai_exec_create_string(state, &operand1_convert_temp, 22);
                     if (error != LAI_ERROR_NONE) {
                         lai_warn("failed to allocate memory for AML string");
                         return error;
@@ -338,7 +487,8 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
                     char *str = lai_exec_string_access(&operand1_convert_temp);
                     lai_strcpy(str, "[Uninitialized Object]");
                 } else if (operand1.type == LAI_PACKAGE) {
-                    lai_api_error_t error = lai_create_string(&operand1_convert_temp, 16);
+                    lai_api_error_t error
+                        = lai_exec_create_string(state, &operand1_convert_temp, 16);
                     if (error != LAI_ERROR_NONE) {
                         lai_warn("failed to allocate memory for AML string");
                         return error;
@@ -359,7 +509,7 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
                         lai_warn("Failed lai_mutate_integer: %s", lai_api_error_to_string(error));
                         return error;
                     }
-                    error = lai_create_buffer(&result, sizeof(uint64_t) * 2);
+                    error = lai_exec_create_buffer(state, &result, sizeof(uint64_t) * 2);
                     if (error != LAI_ERROR_NONE) {
                         lai_warn("failed to allocate memory for AML buffer");
                         return error;
@@ -373,7 +523,8 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
                 case LAI_BUFFER: {
                     if (operand1_convert_temp.type == LAI_STRING) {
                         size_t strl = lai_exec_string_length(&operand1_convert_temp);
-                        lai_api_error_t error = lai_create_buffer(&operand1_convert, strl + 1);
+                        lai_api_error_t error
+                            = lai_exec_create_buffer(state, &operand1_convert, strl + 1);
                         if (error != LAI_ERROR_NONE) {
                             lai_warn("failed to allocate memory for AML buffer");
                             return error;
@@ -386,7 +537,7 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
                         }
                     } else if (operand1_convert_temp.type == LAI_INTEGER) {
                         lai_api_error_t error
-                            = lai_create_buffer(&operand1_convert, sizeof(uint64_t));
+                            = lai_exec_create_buffer(state, &operand1_convert, sizeof(uint64_t));
                         if (error != LAI_ERROR_NONE) {
                             lai_warn("failed to allocate memory for AML buffer");
                             return error;
@@ -402,7 +553,7 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
                     }
                     size_t b0size = lai_exec_buffer_size(&operand0_convert);
                     size_t b1size = lai_exec_buffer_size(&operand1_convert);
-                    lai_api_error_t error = lai_create_buffer(&result, b0size + b1size);
+                    lai_api_error_t error = lai_exec_create_buffer(state, &result, b0size + b1size);
                     if (error != LAI_ERROR_NONE) {
                         lai_warn("Failed to allocate memory for AML buffer");
                         return error;
@@ -422,7 +573,8 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
                             break;
                         }
                         case LAI_INTEGER: {
-                            lai_api_error_t error = lai_create_string(&operand1_convert, 0);
+                            lai_api_error_t error
+                                = lai_exec_create_string(state, &operand1_convert, 0);
                             if (error != LAI_ERROR_NONE) {
                                 lai_warn("failed to allocate memory for AML string");
                                 return error;
@@ -437,7 +589,8 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
                         }
                         case LAI_BUFFER: {
                             // size_t length = lai_exec_buffer_size(&operand1_convert_temp);
-                            lai_api_error_t error = lai_create_string(&operand1_convert, 0);
+                            lai_api_error_t error
+                                = lai_exec_create_string(state, &operand1_convert, 0);
                             if (error != LAI_ERROR_NONE) {
                                 lai_warn("failed to allocate memory for AML string");
                                 return error;
@@ -453,7 +606,8 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
                     }
                     size_t s0len = lai_exec_string_length(&operand0_convert);
                     size_t s1len = lai_exec_string_length(&operand1_convert);
-                    lai_api_error_t error = lai_create_string(&result, s0len + s1len + 1);
+                    lai_api_error_t error
+                        = lai_exec_create_string(state, &result, s0len + s1len + 1);
                     if (error != LAI_ERROR_NONE) {
                         lai_warn("failed to allocate memory for AML string");
                         return error;
@@ -692,7 +846,7 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
                     result.type = LAI_STRING_INDEX;
                     result.string_ptr = object.string_ptr;
                     lai_rc_ref(&object.string_ptr->rc);
-                    result.integer = n;
+                    result.index = n;
                     break;
                 case LAI_BUFFER:
                     if (n >= lai_exec_buffer_size(&object))
@@ -700,14 +854,14 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
                     result.type = LAI_BUFFER_INDEX;
                     result.buffer_ptr = object.buffer_ptr;
                     lai_rc_ref(&object.buffer_ptr->rc);
-                    result.integer = n;
+                    result.index = n;
                     break;
                 case LAI_PACKAGE:
                     if (n >= lai_exec_pkg_size(&object))
                         lai_panic("package Index() out of bounds");
                     result.type = LAI_PACKAGE_INDEX;
                     result.pkg_ptr = object.pkg_ptr;
-                    result.integer = n;
+                    result.index = n;
                     lai_rc_ref(&object.pkg_ptr->rc);
                     break;
                 default:
@@ -797,7 +951,7 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
 
             size_t result_size = (buf1_size - 2) + (buf2_size - 2)
                                  + 2; // (buf1_size - end tag) + (buf2_size - end tag) + end tag
-            lai_create_buffer(&result, result_size);
+            lai_exec_create_buffer(state, &result, result_size);
             char *result_buffer = lai_exec_buffer_access(&result);
 
             memcpy(result_buffer, buf1, buf1_size - 2);
@@ -832,18 +986,18 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
                 case LAI_STRING_INDEX: {
                     char *window = ref.string_ptr->content;
                     result.type = LAI_INTEGER;
-                    result.integer = window[ref.integer];
+                    result.integer = window[ref.index];
                     break;
                 }
                 case LAI_BUFFER_INDEX: {
                     uint8_t *window = ref.buffer_ptr->content;
                     result.type = LAI_INTEGER;
-                    result.integer = window[ref.integer];
+                    result.integer = window[ref.index];
                     break;
                 }
                 case LAI_PACKAGE_INDEX:
                     // TODO: We need to panic if we load an uninitialized entry.
-                    lai_exec_pkg_var_load(&result, ref.pkg_ptr, ref.integer);
+                    lai_exec_pkg_var_load(&result, ref.pkg_ptr, ref.index);
                     break;
                 default:
                     lai_panic("Unexpected object type %d for DeRefOf()", ref.type);
@@ -885,7 +1039,7 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
                     LAI_ENSURE(ctxitem->invocation);
                     ref.type = LAI_ARG_REF;
                     ref.iref_invocation = ctxitem->invocation;
-                    ref.iref_index = operand->index;
+                    ref.index = operand->index;
                     break;
                 }
                 case LAI_LOCAL_NAME: {
@@ -893,7 +1047,7 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
                     LAI_ENSURE(ctxitem->invocation);
                     ref.type = LAI_LOCAL_REF;
                     ref.iref_invocation = ctxitem->invocation;
-                    ref.iref_index = operand->index;
+                    ref.index = operand->index;
                     break;
                 }
                 case LAI_RESOLVED_NAME:
@@ -911,7 +1065,7 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
             LAI_CLEANUP_VAR lai_variable_t operand = LAI_VAR_INITIALIZER;
             lai_exec_get_objectref(state, &operands[0], &operand);
 
-            lai_api_error_t error = lai_obj_to_buffer(&result, &operand);
+            lai_api_error_t error = lai_exec_obj_to_buffer(state, &result, &operand);
             if (error != LAI_ERROR_NONE)
                 lai_panic("Failed ToBuffer: %s", lai_api_error_to_string(error));
 
@@ -922,7 +1076,7 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
             LAI_CLEANUP_VAR lai_variable_t operand = LAI_VAR_INITIALIZER;
             lai_exec_get_objectref(state, &operands[0], &operand);
 
-            lai_api_error_t error = lai_obj_to_decimal_string(&result, &operand);
+            lai_api_error_t error = lai_exec_obj_to_decimal_string(state, &result, &operand);
             if (error != LAI_ERROR_NONE)
                 lai_panic("Failed ToDecimalString: %s", lai_api_error_to_string(error));
 
@@ -933,7 +1087,7 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
             LAI_CLEANUP_VAR lai_variable_t operand = LAI_VAR_INITIALIZER;
             lai_exec_get_objectref(state, &operands[0], &operand);
 
-            lai_api_error_t error = lai_obj_to_hex_string(&result, &operand);
+            lai_api_error_t error = lai_exec_obj_to_hex_string(state, &result, &operand);
             if (error != LAI_ERROR_NONE)
                 lai_panic("Failed ToHexString: %s", lai_api_error_to_string(error));
 
@@ -957,7 +1111,8 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
             LAI_CLEANUP_VAR lai_variable_t size_var = LAI_VAR_INITIALIZER;
             lai_exec_get_integer(state, &operands[1], &size_var);
 
-            lai_api_error_t error = lai_obj_to_string(&result, &operand, size_var.integer);
+            lai_api_error_t error
+                = lai_exec_obj_to_string(state, &result, &operand, size_var.integer);
             if (error != LAI_ERROR_NONE)
                 lai_panic("Failed ToString: %s", lai_api_error_to_string(error));
 
@@ -993,7 +1148,7 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
 
             switch (object.type) {
                 case LAI_STRING: {
-                    lai_api_error_t error = lai_create_string(&result, sz + 1);
+                    lai_api_error_t error = lai_exec_create_string(state, &result, sz + 1);
                     if (error != LAI_ERROR_NONE) {
                         lai_warn("failed to allocate memory for AML buffer");
                         return error;
@@ -1005,7 +1160,7 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
                     break;
                 }
                 case LAI_BUFFER: {
-                    lai_api_error_t error = lai_create_buffer(&result, sz);
+                    lai_api_error_t error = lai_exec_create_buffer(state, &result, sz);
                     if (error != LAI_ERROR_NONE) {
                         lai_warn("failed to allocate memory for AML buffer");
                         return error;
@@ -1030,9 +1185,10 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
             LAI_ENSURE(node->type == LAI_NAMESPACE_DEVICE || node->type == LAI_NAMESPACE_PROCESSOR
                        || node->type == LAI_NAMESPACE_THERMALZONE);
 
-            if (node->notify_override) {
+            struct lai_nsnode_overrides *overrides = lai_ns_get_overrides(node);
+            if (overrides && overrides->notify_override) {
                 lai_api_error_t error;
-                error = node->notify_override(node, code.integer, node->notify_userptr);
+                error = overrides->notify_override(node, code.integer, overrides->notify_userptr);
                 // TODO: for now, there no errors defined.
                 //       Add a way for the host to signal Notify() failure.
                 LAI_ENSURE(!error);
@@ -1273,32 +1429,6 @@ static lai_api_error_t lai_exec_reduce_op(int opcode, lai_state_t *state,
     return LAI_ERROR_NONE;
 }
 
-// lai_exec_run(): This is the main AML interpreter function.
-static int lai_exec_run(lai_state_t *state) {
-    while (lai_exec_peek_stack_back(state)) {
-        if (debug_stack)
-            for (int i = 0;; i++) {
-                lai_stackitem_t *trace_item = lai_exec_peek_stack(state, i);
-                if (!trace_item)
-                    break;
-                switch (trace_item->kind) {
-                    case LAI_OP_STACKITEM:
-                        lai_debug("stack item %d is of type %d, opcode is 0x%x", i,
-                                  trace_item->kind, trace_item->op_opcode);
-                        break;
-                    default:
-                        lai_debug("stack item %d is of type %d", i, trace_item->kind);
-                }
-            }
-
-        lai_api_error_t e;
-        if ((e = lai_exec_process(state)))
-            return e;
-    }
-
-    return 0;
-}
-
 static size_t lai_parse_varint(size_t *out, uint8_t *code, int *pc, int limit) {
     if (*pc + 1 > limit)
         return 1;
@@ -1337,496 +1467,682 @@ static int lai_parse_name(struct lai_amlname *out, uint8_t *code, int *pc, int l
     return 0;
 }
 
-// Process the top-most item of the execution stack.
-static lai_api_error_t lai_exec_process(lai_state_t *state) {
-    lai_stackitem_t *item = lai_exec_peek_stack_back(state);
-    struct lai_ctxitem *ctxitem = lai_exec_peek_ctxstack_back(state);
-    struct lai_blkitem *block = lai_exec_peek_blkstack_back(state);
-    LAI_ENSURE(ctxitem);
-    LAI_ENSURE(block);
-    struct lai_aml_segment *amls = ctxitem->amls;
-    uint8_t *method = ctxitem->code;
-    lai_nsnode_t *ctx_handle = ctxitem->handle;
-    struct lai_invocation *invocation = ctxitem->invocation;
-
-    // Package-size encoding (and similar) needs to know the PC of the opcode.
-    // If an opcode sequence contains a pkgsize, the sequence generally ends at:
-    //     opcode_pc + pkgsize + opcode size.
-    int opcode_pc = block->pc;
-    int limit = block->limit;
-
-    // PC relative to the start of the table.
-    // This matches the offsets in the output of 'iasl -l'.
-    size_t table_pc = sizeof(acpi_header_t) + (method - amls->table->data) + opcode_pc;
-    size_t table_limit_pc = sizeof(acpi_header_t) + (method - amls->table->data) + block->limit;
-
-    // This would be an interpreter bug.
-    if (block->pc > block->limit)
-        lai_panic("execution escaped out of code range"
-                  " [0x%x, limit 0x%x])",
-                  table_pc, table_limit_pc);
-
-    if (item->kind == LAI_POPULATE_STACKITEM) {
-        if (block->pc == block->limit) {
-            lai_exec_pop_blkstack_back(state);
-            lai_exec_pop_ctxstack_back(state);
-            lai_exec_pop_stack_back(state);
-            return LAI_ERROR_NONE;
-        } else {
-            return lai_exec_parse(LAI_EXEC_MODE, state);
-        }
-    } else if (item->kind == LAI_METHOD_STACKITEM) {
-        // ACPI does an implicit Return(0) at the end of a control method.
-        if (block->pc == block->limit) {
-            if (lai_exec_reserve_opstack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-
-            if (state->opstack_ptr) // This is an internal error.
-                lai_panic("opstack is not empty before return");
-            if (item->mth_want_result) {
-                struct lai_operand *result = lai_exec_push_opstack(state);
-                result->tag = LAI_OPERAND_OBJECT;
-                result->object.type = LAI_INTEGER;
-                result->object.integer = 0;
+// Maximal nesting depth of packages that lai_exec_scan_pkg() descends into.
+#define LAI_PKG_SCAN_DEPTH 8
+
+// Counts the nested packages (and their elements) in the initializer of a package, such that
+// the entire tree can be allocated as a single lai_pkg_block.
+// Returns nonzero if the initializer contains elements that are not constant data.
+static int lai_exec_scan_pkg(uint8_t *code, int pc, int limit, int depth, size_t *num_pkgs,
+                             size_t *num_elems) {
+    while (pc < limit) {
+        int opcode_pc = pc;
+        switch (code[pc]) {
+            case ZERO_OP:
+            case ONE_OP:
+            case ONES_OP:
+                pc += 1;
+                break;
+            case BYTEPREFIX:
+                pc += 2;
+                break;
+            case WORDPREFIX:
+                pc += 3;
+                break;
+            case DWORDPREFIX:
+                pc += 5;
+                break;
+            case QWORDPREFIX:
+                pc += 9;
+                break;
+            case STRINGPREFIX:
+                pc++;
+                while (pc < limit && code[pc])
+                    pc++;
+                pc++;
+                break;
+            case BUFFER_OP: {
+                size_t encoded_size;
+                pc++;
+                if (lai_parse_varint(&encoded_size, code, &pc, limit))
+                    return 1;
+                pc = opcode_pc + 1 + encoded_size;
+                break;
+            }
+            case PACKAGE_OP: {
+                size_t encoded_size;
+                pc++;
+                if (depth == LAI_PKG_SCAN_DEPTH
+                    || lai_parse_varint(&encoded_size, code, &pc, limit))
+                    return 1;
+                int end_pc = opcode_pc + 1 + encoded_size;
+                if (end_pc > limit || pc + 1 > end_pc)
+                    return 1;
+                *num_pkgs += 1;
+                *num_elems += code[pc];
+                if (lai_exec_scan_pkg(code, pc + 1, end_pc, depth + 1, num_pkgs, num_elems))
+                    return 1;
+                pc = end_pc;
+                break;
             }
+            default: {
+                if (!lai_is_name(code[pc]))
+                    return 1;
+                struct lai_amlname amln;
+                if (lai_parse_name(&amln, code, &pc, limit))
+                    return 1;
+            }
+        }
+    }
+    return pc != limit;
+}
 
-            // Clean up all per-method namespace nodes.
-            struct lai_list_item *pmi;
-            while ((pmi = lai_list_first(&invocation->per_method_list))) {
-                lai_nsnode_t *node = LAI_CONTAINER_OF(pmi, lai_nsnode_t, per_method_item);
+// Stack items are dispatched through a table of label addresses (a GNU C extension that is
+// also supported by clang). Define LAI_NO_COMPUTED_GOTO to use a switch statement instead.
+#if defined(__GNUC__) && !defined(LAI_NO_COMPUTED_GOTO)
+#define LAI_COMPUTED_GOTO
+#endif
+
+#ifdef LAI_COMPUTED_GOTO
+#define LAI_EXEC_DISPATCH(kind) \
+    goto *lai_exec_targets[(unsigned int)(kind) < LAI_SIZEOF_ARRAY(lai_exec_targets) ? (kind) : 0];
+#define LAI_EXEC_TARGET(kind) target_##kind:
+#define LAI_EXEC_INVALID_TARGET target_invalid:
+#else
+#define LAI_EXEC_DISPATCH(kind) switch (kind)
+#define LAI_EXEC_TARGET(kind) case kind:
+#define LAI_EXEC_INVALID_TARGET default:
+#endif
 
-                if (node->type == LAI_NAMESPACE_BUFFER_FIELD) {
-                    if (lai_rc_unref(&node->bf_buffer->rc)) {
-                        laihost_free(node->bf_buffer->content, node->bf_buffer->size);
-                        laihost_free(node->bf_buffer, sizeof(struct lai_buffer_head));
-                    }
+// lai_exec_run(): This is the main AML interpreter function.
+// Each iteration of the loop processes the top-most item of the stack.
+static int lai_exec_run(lai_state_t *state) {
+#ifdef LAI_COMPUTED_GOTO
+    static const void *const lai_exec_targets[] = {
+        [0] = &&target_invalid,
+        [LAI_POPULATE_STACKITEM] = &&target_LAI_POPULATE_STACKITEM,
+        [LAI_METHOD_STACKITEM] = &&target_LAI_METHOD_STACKITEM,
+        [LAI_LOOP_STACKITEM] = &&target_LAI_LOOP_STACKITEM,
+        [LAI_COND_STACKITEM] = &&target_LAI_COND_STACKITEM,
+        [LAI_BUFFER_STACKITEM] = &&target_LAI_BUFFER_STACKITEM,
+        [LAI_PACKAGE_STACKITEM] = &&target_LAI_PACKAGE_STACKITEM,
+        [LAI_NODE_STACKITEM] = &&target_LAI_NODE_STACKITEM,
+        [LAI_OP_STACKITEM] = &&target_LAI_OP_STACKITEM,
+        [LAI_INVOKE_STACKITEM] = &&target_LAI_INVOKE_STACKITEM,
+        [LAI_RETURN_STACKITEM] = &&target_LAI_RETURN_STACKITEM,
+        [LAI_BANKFIELD_STACKITEM] = &&target_LAI_BANKFIELD_STACKITEM,
+        [LAI_VARPACKAGE_STACKITEM] = &&target_LAI_VARPACKAGE_STACKITEM,
+    };
+#endif
+
+    lai_stackitem_t *item;
+    while ((item = lai_exec_peek_stack_back(state))) {
+        if (debug_stack)
+            for (int i = 0;; i++) {
+                lai_stackitem_t *trace_item = lai_exec_peek_stack(state, i);
+                if (!trace_item)
+                    break;
+                switch (trace_item->kind) {
+                    case LAI_OP_STACKITEM:
+                        lai_debug("stack item %d is of type %d, opcode is 0x%x", i,
+                                  trace_item->kind, trace_item->op_opcode);
+                        break;
+                    default:
+                        lai_debug("stack item %d is of type %d", i, trace_item->kind);
                 }
-
-                lai_uninstall_nsnode(node);
-                lai_list_unlink(&node->per_method_item);
             }
 
-            lai_exec_pop_blkstack_back(state);
-            lai_exec_pop_ctxstack_back(state);
-            lai_exec_pop_stack_back(state);
-            return LAI_ERROR_NONE;
-        } else {
-            return lai_exec_parse(LAI_EXEC_MODE, state);
-        }
-    } else if (item->kind == LAI_BUFFER_STACKITEM) {
-        int k = state->opstack_ptr - item->opstack_frame;
-        LAI_ENSURE(k <= 1);
-        if (k == 1) {
-            LAI_CLEANUP_VAR lai_variable_t size = LAI_VAR_INITIALIZER;
-            struct lai_operand *operand = lai_exec_get_opstack(state, item->opstack_frame);
-            lai_exec_get_objectref(state, operand, &size);
-            lai_exec_pop_opstack_back(state);
-
-            // Note that not all elements of the buffer need to be initialized.
-            LAI_CLEANUP_VAR lai_variable_t result = LAI_VAR_INITIALIZER;
-            if (lai_create_buffer(&result, size.integer) != LAI_ERROR_NONE)
-                lai_panic("failed to allocate memory for AML buffer");
-
-            int initial_size = block->limit - block->pc;
-            if (initial_size < 0)
-                lai_panic("buffer initializer has negative size");
-            if (initial_size > (int)lai_exec_buffer_size(&result))
-                lai_panic("buffer initializer overflows buffer");
-            memcpy(lai_exec_buffer_access(&result), method + block->pc, initial_size);
-
-            if (item->buf_want_result) {
-                // Note: there is no need to reserve() as we pop an operand above.
-                struct lai_operand *opstack_res = lai_exec_push_opstack(state);
-                opstack_res->tag = LAI_OPERAND_OBJECT;
-                lai_var_move(&opstack_res->object, &result);
+        lai_api_error_t e;
+        struct lai_ctxitem *ctxitem = lai_exec_peek_ctxstack_back(state);
+        struct lai_blkitem *block = lai_exec_peek_blkstack_back(state);
+        LAI_ENSURE(ctxitem);
+        LAI_ENSURE(block);
+        struct lai_aml_segment *amls = ctxitem->amls;
+        uint8_t *method = ctxitem->code;
+        lai_nsnode_t *ctx_handle = ctxitem->handle;
+        struct lai_invocation *invocation = ctxitem->invocation;
+
+        // Package-size encoding (and similar) needs to know the PC of the opcode.
+        // If an opcode sequence contains a pkgsize, the sequence generally ends at:
+        //     opcode_pc + pkgsize + opcode size.
+        int opcode_pc = block->pc;
+        int limit = block->limit;
+
+        // PC relative to the start of the table.
+        // This matches the offsets in the output of 'iasl -l'.
+        size_t table_pc = sizeof(acpi_header_t) + (method - amls->table->data) + opcode_pc;
+        size_t table_limit_pc = sizeof(acpi_header_t) + (method - amls->table->data) + block->limit;
+
+        // This would be an interpreter bug.
+        if (block->pc > block->limit)
+            lai_panic("execution escaped out of code range"
+                      " [0x%x, limit 0x%x])",
+                      table_pc, table_limit_pc);
+
+        LAI_EXEC_DISPATCH(item->kind) {
+            LAI_EXEC_TARGET(LAI_POPULATE_STACKITEM) {
+                if (block->pc == block->limit) {
+                    lai_exec_pop_blkstack_back(state);
+                    lai_exec_pop_ctxstack_back(state);
+                    lai_exec_pop_stack_back(state);
+                    continue;
+                }
+                // Table-level code is not part of an evaluation that resets the arena.
+                lai_exec_trim_arena(state);
+                if ((e = lai_exec_parse(LAI_EXEC_MODE, state)))
+                    return e;
+                continue;
             }
+            LAI_EXEC_TARGET(LAI_METHOD_STACKITEM) {
+                // ACPI does an implicit Return(0) at the end of a control method.
+                if (block->pc == block->limit) {
+                    if (lai_exec_reserve_opstack(state))
+                        return LAI_ERROR_OUT_OF_MEMORY;
+
+                    if (state->opstack_ptr) // This is an internal error.
+                        lai_panic("opstack is not empty before return");
+                    if (item->mth_want_result) {
+                        struct lai_operand *result = lai_exec_push_opstack(state);
+                        result->tag = LAI_OPERAND_OBJECT;
+                        result->object.type = LAI_INTEGER;
+                        result->object.integer = 0;
+                    }
 
-            lai_exec_pop_blkstack_back(state);
-            lai_exec_pop_stack_back(state);
-            return LAI_ERROR_NONE;
-        } else {
-            return lai_exec_parse(LAI_OBJECT_MODE, state);
-        }
-    } else if (item->kind == LAI_PACKAGE_STACKITEM || item->kind == LAI_VARPACKAGE_STACKITEM) {
-        struct lai_operand *frame = lai_exec_get_opstack(state, item->opstack_frame);
-        if (item->pkg_phase == 0) {
-            lai_api_error_t error = LAI_ERROR_NONE;
-            if (item->kind == LAI_PACKAGE_STACKITEM)
-                error = lai_exec_parse(LAI_IMMEDIATE_BYTE_MODE, state);
-            else
-                error = lai_exec_parse(LAI_OBJECT_MODE, state);
-
-            item->pkg_phase++;
-
-            return error;
-        } else if (item->pkg_phase == 1) {
-            LAI_CLEANUP_VAR lai_variable_t size = LAI_VAR_INITIALIZER;
-            lai_exec_get_integer(state, &frame[1], &size);
+                    // Clean up all per-method namespace nodes.
+                    struct lai_list_item *pmi;
+                    while ((pmi = lai_list_first(&invocation->per_method_list))) {
+                        lai_nsnode_t *node = LAI_CONTAINER_OF(pmi, lai_nsnode_t, per_method_item);
 
-            lai_exec_pop_opstack_back(state);
+                        if (node->type == LAI_NAMESPACE_BUFFER_FIELD)
+                            lai_exec_unref_buffer(node->bf_buffer);
 
-            if (lai_create_pkg(&frame[0].object, size.integer) != LAI_ERROR_NONE)
-                lai_panic("could not allocate memory for package");
+                        lai_uninstall_nsnode(node);
+                        lai_list_unlink(&node->per_method_item);
+                    }
 
-            item->pkg_phase++;
+                    lai_exec_pop_blkstack_back(state);
+                    lai_exec_pop_ctxstack_back(state);
+                    lai_exec_pop_stack_back(state);
+                    continue;
+                }
+                if ((e = lai_exec_parse(LAI_EXEC_MODE, state)))
+                    return e;
+                continue;
+            }
+            LAI_EXEC_TARGET(LAI_BUFFER_STACKITEM) {
+                int k = state->opstack_ptr - item->opstack_frame;
+                LAI_ENSURE(k <= 1);
+                if (k == 1) {
+                    LAI_CLEANUP_VAR lai_variable_t size = LAI_VAR_INITIALIZER;
+                    struct lai_operand *operand = lai_exec_get_opstack(state, item->opstack_frame);
+                    lai_exec_get_objectref(state, operand, &size);
+                    lai_exec_pop_opstack_back(state);
+
+                    // Note that not all elements of the buffer need to be initialized.
+                    LAI_CLEANUP_VAR lai_variable_t result = LAI_VAR_INITIALIZER;
+                    if (lai_create_buffer(&result, size.integer) != LAI_ERROR_NONE)
+                        lai_panic("failed to allocate memory for AML buffer");
+
+                    int initial_size = block->limit - block->pc;
+                    if (initial_size < 0)
+                        lai_panic("buffer initializer has negative size");
+                    if (initial_size > (int)lai_exec_buffer_size(&result))
+                        lai_panic("buffer initializer overflows buffer");
+                    memcpy(lai_exec_buffer_access(&result), method + block->pc, initial_size);
+
+                    if (item->buf_want_result) {
+                        // Note: there is no need to reserve() as we pop an operand above.
+                        struct lai_operand *opstack_res = lai_exec_push_opstack(state);
+                        opstack_res->tag = LAI_OPERAND_OBJECT;
+                        lai_var_move(&opstack_res->object, &result);
+                    }
 
-            return LAI_ERROR_NONE;
-        }
+                    lai_exec_pop_blkstack_back(state);
+                    lai_exec_pop_stack_back(state);
+                    continue;
+                }
+                if ((e = lai_exec_parse(LAI_OBJECT_MODE, state)))
+                    return e;
+                continue;
+            }
+            LAI_EXEC_TARGET(LAI_PACKAGE_STACKITEM)
+            LAI_EXEC_TARGET(LAI_VARPACKAGE_STACKITEM) {
+                struct lai_operand *frame = lai_exec_get_opstack(state, item->opstack_frame);
+                if (item->pkg_phase == 0) {
+                    lai_api_error_t error = LAI_ERROR_NONE;
+                    if (item->kind == LAI_PACKAGE_STACKITEM)
+                        error = lai_exec_parse(LAI_IMMEDIATE_BYTE_MODE, state);
+                    else
+                        error = lai_exec_parse(LAI_OBJECT_MODE, state);
+
+                    item->pkg_phase++;
+
+                    if (error)
+                        return error;
+                    continue;
+                } else if (item->pkg_phase == 1) {
+                    LAI_CLEANUP_VAR lai_variable_t size = LAI_VAR_INITIALIZER;
+                    lai_exec_get_integer(state, &frame[1], &size);
+
+                    lai_exec_pop_opstack_back(state);
+
+                    // Nested packages are allocated from the block of their parent. The outermost
+                    // package of a constant tree allocates a block for the entire tree.
+                    lai_stackitem_t *parent = lai_exec_peek_stack(state, 1);
+                    if (parent
+                        && (parent->kind == LAI_PACKAGE_STACKITEM
+                            || parent->kind == LAI_VARPACKAGE_STACKITEM)
+                        && parent->pkg_block
+                        && !lai_exec_create_pkg_in_block(&frame[0].object, parent->pkg_block,
+                                                         size.integer)) {
+                        item->pkg_block = parent->pkg_block;
+                    } else {
+                        size_t num_pkgs = 0, num_elems = 0;
+                        if (!lai_exec_scan_pkg(method, block->pc, limit, 0, &num_pkgs, &num_elems)
+                            && num_pkgs)
+                            item->pkg_block = lai_exec_alloc_pkg_block(1 + num_pkgs,
+                                                                       size.integer + num_elems);
+                        if (item->pkg_block) {
+                            LAI_ENSURE(!lai_exec_create_pkg_in_block(
+                                &frame[0].object, item->pkg_block, size.integer));
+                        } else if (lai_create_pkg(&frame[0].object, size.integer)
+                                   != LAI_ERROR_NONE) {
+                            lai_panic("could not allocate memory for package");
+                        }
+                    }
 
-        if (state->opstack_ptr == item->opstack_frame + 2) {
-            struct lai_operand *package = &frame[0];
-            LAI_ENSURE(package->tag == LAI_OPERAND_OBJECT);
-            struct lai_operand *initializer = &frame[1];
-            LAI_ENSURE(initializer->tag == LAI_OPERAND_OBJECT);
+                    item->pkg_phase++;
 
-            if (item->pkg_index == (int)lai_exec_pkg_size(&package->object))
-                lai_panic("package initializer overflows its size");
-            LAI_ENSURE(item->pkg_index < (int)lai_exec_pkg_size(&package->object));
+                    continue;
+                }
 
-            lai_exec_pkg_store(&initializer->object, &package->object, item->pkg_index);
-            item->pkg_index++;
-            lai_exec_pop_opstack_back(state);
-        }
-        LAI_ENSURE(state->opstack_ptr == item->opstack_frame + 1);
+                if (state->opstack_ptr == item->opstack_frame + 2) {
+                    struct lai_operand *package = &frame[0];
+                    LAI_ENSURE(package->tag == LAI_OPERAND_OBJECT);
+                    struct lai_operand *initializer = &frame[1];
+                    LAI_ENSURE(initializer->tag == LAI_OPERAND_OBJECT);
 
-        if (block->pc == block->limit) {
-            if (!item->pkg_want_result)
-                lai_exec_pop_opstack_back(state);
+                    if (item->pkg_index == (int)lai_exec_pkg_size(&package->object))
+                        lai_panic("package initializer overflows its size");
+                    LAI_ENSURE(item->pkg_index < (int)lai_exec_pkg_size(&package->object));
 
-            lai_exec_pop_blkstack_back(state);
-            lai_exec_pop_stack_back(state);
-            return LAI_ERROR_NONE;
-        } else {
-            return lai_exec_parse(LAI_DATA_MODE, state);
-        }
-    } else if (item->kind == LAI_NODE_STACKITEM) {
-        int k = state->opstack_ptr - item->opstack_frame;
-        if (!item->node_arg_modes[k]) {
-            struct lai_operand *operands = lai_exec_get_opstack(state, item->opstack_frame);
-            lai_exec_reduce_node(item->node_opcode, state, operands, ctx_handle);
-            lai_exec_pop_opstack(state, k);
+                    lai_exec_pkg_store(&initializer->object, &package->object, item->pkg_index);
+                    item->pkg_index++;
+                    lai_exec_pop_opstack_back(state);
+                }
+                LAI_ENSURE(state->opstack_ptr == item->opstack_frame + 1);
 
-            lai_exec_pop_stack_back(state);
-            return LAI_ERROR_NONE;
-        } else {
-            return lai_exec_parse(item->node_arg_modes[k], state);
-        }
-    } else if (item->kind == LAI_OP_STACKITEM) {
-        int k = state->opstack_ptr - item->opstack_frame;
-        //            lai_debug("got %d parameters", k);
-        if (!item->op_arg_modes[k]) {
-            if (lai_exec_reserve_opstack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
+                if (block->pc == block->limit) {
+                    if (!item->pkg_want_result)
+                        lai_exec_pop_opstack_back(state);
 
-            lai_variable_t result = {0};
-            struct lai_operand *operands = lai_exec_get_opstack(state, item->opstack_frame);
-            lai_api_error_t error = lai_exec_reduce_op(item->op_opcode, state, operands, &result);
-            if (error != LAI_ERROR_NONE) {
-                return error;
+                    lai_exec_pop_blkstack_back(state);
+                    lai_exec_pop_stack_back(state);
+                    continue;
+                }
+                if ((e = lai_exec_parse(LAI_DATA_MODE, state)))
+                    return e;
+                continue;
             }
-            lai_exec_pop_opstack(state, k);
+            LAI_EXEC_TARGET(LAI_NODE_STACKITEM) {
+                int k = state->opstack_ptr - item->opstack_frame;
+                if (!item->node_arg_modes[k]) {
+                    struct lai_operand *operands = lai_exec_get_opstack(state, item->opstack_frame);
+                    lai_exec_reduce_node(item->node_opcode, state, operands, ctx_handle);
+                    lai_exec_pop_opstack(state, k);
 
-            if (item->op_want_result) {
-                struct lai_operand *opstack_res = lai_exec_push_opstack(state);
-                opstack_res->tag = LAI_OPERAND_OBJECT;
-                lai_var_move(&opstack_res->object, &result);
-            } else {
-                lai_var_finalize(&result);
+                    lai_exec_pop_stack_back(state);
+                    continue;
+                }
+                if ((e = lai_exec_parse(item->node_arg_modes[k], state)))
+                    return e;
+                continue;
             }
+            LAI_EXEC_TARGET(LAI_OP_STACKITEM) {
+                int k = state->opstack_ptr - item->opstack_frame;
+                //            lai_debug("got %d parameters", k);
+                if (!item->op_arg_modes[k]) {
+                    if (lai_exec_reserve_opstack(state))
+                        return LAI_ERROR_OUT_OF_MEMORY;
+
+                    lai_variable_t result = {0};
+                    struct lai_operand *operands
+                        = lai_exec_get_opstack(state, item->opstack_frame);
+                    lai_api_error_t error
+                        = lai_exec_reduce_op(item->op_opcode, state, operands, &result);
+                    if (error != LAI_ERROR_NONE) {
+                        if (error)
+                            return error;
+                        continue;
+                    }
+                    lai_exec_pop_opstack(state, k);
 
-            lai_exec_pop_stack_back(state);
-            return LAI_ERROR_NONE;
-        } else {
-            return lai_exec_parse(item->op_arg_modes[k], state);
-        }
-    } else if (item->kind == LAI_INVOKE_STACKITEM) {
-        int argc = item->ivk_argc;
-        int want_result = item->ivk_want_result;
-        int k = state->opstack_ptr - item->opstack_frame;
-        LAI_ENSURE(k <= argc + 1);
-        if (k == argc + 1) { // First operand is the method name.
-            if (lai_exec_reserve_ctxstack(state) || lai_exec_reserve_blkstack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-
-            struct lai_operand *opstack_method = lai_exec_get_opstack(state, item->opstack_frame);
-            LAI_ENSURE(opstack_method->tag == LAI_RESOLVED_NAME);
-
-            lai_nsnode_t *handle = opstack_method->handle;
-            LAI_ENSURE(handle->type == LAI_NAMESPACE_METHOD);
-
-            // TODO: Make sure that this does not leak memory.
-            lai_variable_t args[7];
-            memset(args, 0, sizeof(lai_variable_t) * 7);
+                    if (item->op_want_result) {
+                        struct lai_operand *opstack_res = lai_exec_push_opstack(state);
+                        opstack_res->tag = LAI_OPERAND_OBJECT;
+                        lai_var_move(&opstack_res->object, &result);
+                    } else {
+                        lai_var_finalize(&result);
+                    }
 
-            for (int i = 0; i < argc; i++) {
-                struct lai_operand *operand
-                    = lai_exec_get_opstack(state, item->opstack_frame + 1 + i);
-                lai_exec_get_objectref(state, operand, &args[i]);
+                    lai_exec_pop_stack_back(state);
+                    continue;
+                }
+                if ((e = lai_exec_parse(item->op_arg_modes[k], state)))
+                    return e;
+                continue;
             }
+            LAI_EXEC_TARGET(LAI_INVOKE_STACKITEM) {
+                int argc = item->ivk_argc;
+                int want_result = item->ivk_want_result;
+                int k = state->opstack_ptr - item->opstack_frame;
+                LAI_ENSURE(k <= argc + 1);
+                if (k == argc + 1) { // First operand is the method name.
+                    if (lai_exec_reserve_ctxstack(state) || lai_exec_reserve_blkstack(state))
+                        return LAI_ERROR_OUT_OF_MEMORY;
+
+                    struct lai_operand *opstack_method
+                        = lai_exec_get_opstack(state, item->opstack_frame);
+                    LAI_ENSURE(opstack_method->tag == LAI_RESOLVED_NAME);
+
+                    lai_nsnode_t *handle = opstack_method->handle;
+                    LAI_ENSURE(handle->type == LAI_NAMESPACE_METHOD);
+
+                    // TODO: Make sure that this does not leak memory.
+                    lai_variable_t args[7];
+                    memset(args, 0, sizeof(lai_variable_t) * 7);
+
+                    for (int i = 0; i < argc; i++) {
+                        struct lai_operand *operand
+                            = lai_exec_get_opstack(state, item->opstack_frame + 1 + i);
+                        lai_exec_get_objectref(state, operand, &args[i]);
+                    }
 
-            lai_exec_pop_opstack(state, argc + 1);
-            lai_exec_pop_stack_back(state);
+                    lai_exec_pop_opstack(state, argc + 1);
+                    lai_exec_pop_stack_back(state);
 
-            if (handle->method_override) {
-                // It's an OS-defined method.
-                // TODO: Verify the number of argument to the overridden method.
-                LAI_CLEANUP_VAR lai_variable_t method_result = LAI_VAR_INITIALIZER;
-                int e = handle->method_override(args, &method_result);
+                    struct lai_nsnode_overrides *overrides = lai_ns_get_overrides(handle);
+                    if (overrides && overrides->method_override) {
+                        // It's an OS-defined method.
+                        // TODO: Verify the number of argument to the overridden method.
+                        LAI_CLEANUP_VAR lai_variable_t method_result = LAI_VAR_INITIALIZER;
+                        int e = overrides->method_override(args, &method_result);
 
-                if (e) {
-                    lai_warn("overriden control method failed");
-                    return LAI_ERROR_EXECUTION_FAILURE;
-                }
-                if (want_result) {
-                    // Note: there is no need to reserve() as we pop an operand above.
-                    struct lai_operand *opstack_res = lai_exec_push_opstack(state);
-                    opstack_res->tag = LAI_OPERAND_OBJECT;
-                    lai_var_move(&opstack_res->object, &method_result);
+                        if (e) {
+                            lai_warn("overriden control method failed");
+                            return LAI_ERROR_EXECUTION_FAILURE;
+                        }
+                        if (want_result) {
+                            // Note: there is no need to reserve() as we pop an operand above.
+                            struct lai_operand *opstack_res = lai_exec_push_opstack(state);
+                            opstack_res->tag = LAI_OPERAND_OBJECT;
+                            lai_var_move(&opstack_res->object, &method_result);
+                        }
+                    } else {
+                        // It's an AML method.
+                        LAI_ENSURE(handle->amls);
+
+                        struct lai_ctxitem *method_ctxitem = lai_exec_push_ctxstack(state);
+                        method_ctxitem->amls = handle->amls;
+                        method_ctxitem->code = handle->pointer;
+                        method_ctxitem->handle = handle;
+                        method_ctxitem->invocation = lai_exec_alloc_invocation(state);
+                        if (!method_ctxitem->invocation)
+                            lai_panic("could not allocate memory for method invocation");
+                        method_ctxitem->ir = lai_get_method_ir(handle);
+
+                        for (int i = 0; i < argc; i++)
+                            lai_var_move(&method_ctxitem->invocation->arg[i], &args[i]);
+
+                        struct lai_blkitem *blkitem = lai_exec_push_blkstack(state);
+                        blkitem->pc = 0;
+                        blkitem->limit = handle->size;
+
+                        // Note: there is no need to reserve() as we pop a stackitem above.
+                        lai_stackitem_t *item = lai_exec_push_stack(state);
+                        item->kind = LAI_METHOD_STACKITEM;
+                        item->mth_want_result = want_result;
+                    }
+                    continue;
                 }
-            } else {
-                // It's an AML method.
-                LAI_ENSURE(handle->amls);
-
-                struct lai_ctxitem *method_ctxitem = lai_exec_push_ctxstack(state);
-                method_ctxitem->amls = handle->amls;
-                method_ctxitem->code = handle->pointer;
-                method_ctxitem->handle = handle;
-                method_ctxitem->invocation = laihost_malloc(sizeof(struct lai_invocation));
-                if (!method_ctxitem->invocation)
-                    lai_panic("could not allocate memory for method invocation");
-                memset(method_ctxitem->invocation, 0, sizeof(struct lai_invocation));
-                lai_list_init(&method_ctxitem->invocation->per_method_list);
+                if ((e = lai_exec_parse(LAI_OBJECT_MODE, state)))
+                    return e;
+                continue;
+            }
+            LAI_EXEC_TARGET(LAI_RETURN_STACKITEM) {
+                int k = state->opstack_ptr - item->opstack_frame;
+                LAI_ENSURE(k <= 1);
+                if (k == 1) {
+                    LAI_CLEANUP_VAR lai_variable_t result = LAI_VAR_INITIALIZER;
+                    struct lai_operand *operand = lai_exec_get_opstack(state, item->opstack_frame);
+                    lai_exec_get_objectref(state, operand, &result);
+                    lai_exec_pop_opstack_back(state);
+
+                    // Find the last LAI_METHOD_STACKITEM on the stack.
+                    int m = 0;
+                    lai_stackitem_t *method_item;
+                    while (1) {
+                        // Ignore the top-most LAI_RETURN_STACKITEM.
+                        method_item = lai_exec_peek_stack(state, 1 + m);
+                        if (!method_item)
+                            lai_panic("Return() outside of control method()");
+                        if (method_item->kind == LAI_METHOD_STACKITEM)
+                            break;
+                        if (method_item->kind != LAI_COND_STACKITEM
+                            && method_item->kind != LAI_LOOP_STACKITEM)
+                            lai_panic("Return() cannot skip item of type %d", method_item->kind);
+                        m++;
+                    }
 
-                for (int i = 0; i < argc; i++)
-                    lai_var_move(&method_ctxitem->invocation->arg[i], &args[i]);
+                    int want_result = method_item->mth_want_result;
 
-                struct lai_blkitem *blkitem = lai_exec_push_blkstack(state);
-                blkitem->pc = 0;
-                blkitem->limit = handle->size;
+                    // Clean up all per-method namespace nodes.
+                    struct lai_list_item *pmi;
+                    while ((pmi = lai_list_first(&invocation->per_method_list))) {
+                        lai_nsnode_t *node = LAI_CONTAINER_OF(pmi, lai_nsnode_t, per_method_item);
 
-                // Note: there is no need to reserve() as we pop a stackitem above.
-                lai_stackitem_t *item = lai_exec_push_stack(state);
-                item->kind = LAI_METHOD_STACKITEM;
-                item->mth_want_result = want_result;
-            }
-            return LAI_ERROR_NONE;
-        } else {
-            return lai_exec_parse(LAI_OBJECT_MODE, state);
-        }
-    } else if (item->kind == LAI_RETURN_STACKITEM) {
-        int k = state->opstack_ptr - item->opstack_frame;
-        LAI_ENSURE(k <= 1);
-        if (k == 1) {
-            LAI_CLEANUP_VAR lai_variable_t result = LAI_VAR_INITIALIZER;
-            struct lai_operand *operand = lai_exec_get_opstack(state, item->opstack_frame);
-            lai_exec_get_objectref(state, operand, &result);
-            lai_exec_pop_opstack_back(state);
-
-            // Find the last LAI_METHOD_STACKITEM on the stack.
-            int m = 0;
-            lai_stackitem_t *method_item;
-            while (1) {
-                // Ignore the top-most LAI_RETURN_STACKITEM.
-                method_item = lai_exec_peek_stack(state, 1 + m);
-                if (!method_item)
-                    lai_panic("Return() outside of control method()");
-                if (method_item->kind == LAI_METHOD_STACKITEM)
-                    break;
-                if (method_item->kind != LAI_COND_STACKITEM
-                    && method_item->kind != LAI_LOOP_STACKITEM)
-                    lai_panic("Return() cannot skip item of type %d", method_item->kind);
-                m++;
-            }
+                        if (node->type == LAI_NAMESPACE_BUFFER_FIELD)
+                            lai_exec_unref_buffer(node->bf_buffer);
 
-            // Push the return value.
-            if (method_item->mth_want_result) {
-                // Note: there is no need to reserve() as we pop an operand above.
-                struct lai_operand *opstack_res = lai_exec_push_opstack(state);
-                opstack_res->tag = LAI_OPERAND_OBJECT;
-                lai_obj_clone(&opstack_res->object, &result);
-            }
+                        lai_uninstall_nsnode(node);
+                        lai_list_unlink(&node->per_method_item);
+                    }
 
-            // Clean up all per-method namespace nodes.
-            struct lai_list_item *pmi;
-            while ((pmi = lai_list_first(&invocation->per_method_list))) {
-                lai_nsnode_t *node = LAI_CONTAINER_OF(pmi, lai_nsnode_t, per_method_item);
+                    // Pop the LAI_RETURN_STACKITEM.
+                    lai_exec_pop_stack_back(state);
 
-                if (node->type == LAI_NAMESPACE_BUFFER_FIELD) {
-                    if (lai_rc_unref(&node->bf_buffer->rc)) {
-                        laihost_free(node->bf_buffer->content, node->bf_buffer->size);
-                        laihost_free(node->bf_buffer, sizeof(struct lai_buffer_head));
+                    // Pop all nested loops/conditions.
+                    for (int i = 0; i < m; i++) {
+                        lai_stackitem_t *pop_item = lai_exec_peek_stack_back(state);
+                        LAI_ENSURE(pop_item->kind == LAI_COND_STACKITEM
+                                   || pop_item->kind == LAI_LOOP_STACKITEM);
+                        lai_exec_pop_blkstack_back(state);
+                        lai_exec_pop_stack_back(state);
                     }
-                }
 
-                lai_uninstall_nsnode(node);
-                lai_list_unlink(&node->per_method_item);
-            }
+                    // Pop the LAI_METHOD_STACKITEM.
+                    lai_exec_pop_ctxstack_back(state);
+                    lai_exec_pop_blkstack_back(state);
+                    lai_exec_pop_stack_back(state);
 
-            // Pop the LAI_RETURN_STACKITEM.
-            lai_exec_pop_stack_back(state);
-
-            // Pop all nested loops/conditions.
-            for (int i = 0; i < m; i++) {
-                lai_stackitem_t *pop_item = lai_exec_peek_stack_back(state);
-                LAI_ENSURE(pop_item->kind == LAI_COND_STACKITEM
-                           || pop_item->kind == LAI_LOOP_STACKITEM);
-                lai_exec_pop_blkstack_back(state);
-                lai_exec_pop_stack_back(state);
+                    // Push the return value. As ARGx and LOCALx are gone at this point,
+                    // temporaries (e.g., Return (Local0)) are usually moved, not cloned.
+                    if (want_result) {
+                        // Note: there is no need to reserve() as we pop an operand above.
+                        struct lai_operand *opstack_res = lai_exec_push_opstack(state);
+                        opstack_res->tag = LAI_OPERAND_OBJECT;
+                        lai_exec_move_result(&opstack_res->object, &result);
+                    }
+                    continue;
+                }
+                if ((e = lai_exec_parse(LAI_OBJECT_MODE, state)))
+                    return e;
+                continue;
             }
-
-            // Pop the LAI_METHOD_STACKITEM.
-            lai_exec_pop_ctxstack_back(state);
-            lai_exec_pop_blkstack_back(state);
-            lai_exec_pop_stack_back(state);
-            return LAI_ERROR_NONE;
-        } else {
-            return lai_exec_parse(LAI_OBJECT_MODE, state);
-        }
-    } else if (item->kind == LAI_LOOP_STACKITEM) {
-        if (!item->loop_state) {
-            // We are at the beginning of a loop and need to check the predicate.
-            int k = state->opstack_ptr - item->opstack_frame;
-            LAI_ENSURE(k <= 1);
-            if (k == 1) {
-                LAI_CLEANUP_VAR lai_variable_t predicate = LAI_VAR_INITIALIZER;
-                struct lai_operand *operand = lai_exec_get_opstack(state, item->opstack_frame);
-                lai_exec_get_integer(state, operand, &predicate);
-                lai_exec_pop_opstack_back(state);
-
-                if (predicate.integer) {
-                    item->loop_state = LAI_LOOP_ITERATION;
+            LAI_EXEC_TARGET(LAI_LOOP_STACKITEM) {
+                if (!item->loop_state) {
+                    // We are at the beginning of a loop and need to check the predicate.
+                    int k = state->opstack_ptr - item->opstack_frame;
+                    LAI_ENSURE(k <= 1);
+                    if (k == 1) {
+                        LAI_CLEANUP_VAR lai_variable_t predicate = LAI_VAR_INITIALIZER;
+                        struct lai_operand *operand
+                            = lai_exec_get_opstack(state, item->opstack_frame);
+                        lai_exec_get_integer(state, operand, &predicate);
+                        lai_exec_pop_opstack_back(state);
+
+                        if (predicate.integer) {
+                            item->loop_state = LAI_LOOP_ITERATION;
+                        } else {
+                            lai_exec_pop_blkstack_back(state);
+                            lai_exec_pop_stack_back(state);
+                        }
+                        continue;
+                    }
+                    if ((e = lai_exec_parse(LAI_OBJECT_MODE, state)))
+                        return e;
+                    continue;
                 } else {
-                    lai_exec_pop_blkstack_back(state);
-                    lai_exec_pop_stack_back(state);
+                    LAI_ENSURE(item->loop_state == LAI_LOOP_ITERATION);
+                    // Unconditionally reset the loop's state to recheck the predicate.
+                    if (block->pc == block->limit) {
+                        item->loop_state = 0;
+                        block->pc = item->loop_pred;
+                        lai_exec_trim_arena(state);
+                        continue;
+                    }
+                    if ((e = lai_exec_parse(LAI_EXEC_MODE, state)))
+                        return e;
+                    continue;
                 }
-                return LAI_ERROR_NONE;
-            } else {
-                return lai_exec_parse(LAI_OBJECT_MODE, state);
-            }
-        } else {
-            LAI_ENSURE(item->loop_state == LAI_LOOP_ITERATION);
-            // Unconditionally reset the loop's state to recheck the predicate.
-            if (block->pc == block->limit) {
-                item->loop_state = 0;
-                block->pc = item->loop_pred;
-                return LAI_ERROR_NONE;
-            } else {
-                return lai_exec_parse(LAI_EXEC_MODE, state);
             }
-        }
-    } else if (item->kind == LAI_COND_STACKITEM) {
-        if (!item->cond_state) {
-            // We are at the beginning of the condition and need to check the predicate.
-            int k = state->opstack_ptr - item->opstack_frame;
-            LAI_ENSURE(k <= 1);
-            if (k == 1) {
-                LAI_CLEANUP_VAR lai_variable_t predicate = LAI_VAR_INITIALIZER;
-                struct lai_operand *operand = lai_exec_get_opstack(state, item->opstack_frame);
-                lai_exec_get_integer(state, operand, &predicate);
-                lai_exec_pop_opstack_back(state);
-
-                if (predicate.integer) {
-                    item->cond_state = LAI_COND_BRANCH;
+            LAI_EXEC_TARGET(LAI_COND_STACKITEM) {
+                if (!item->cond_state) {
+                    // We are at the beginning of the condition and need to check the predicate.
+                    int k = state->opstack_ptr - item->opstack_frame;
+                    LAI_ENSURE(k <= 1);
+                    if (k == 1) {
+                        LAI_CLEANUP_VAR lai_variable_t predicate = LAI_VAR_INITIALIZER;
+                        struct lai_operand *operand
+                            = lai_exec_get_opstack(state, item->opstack_frame);
+                        lai_exec_get_integer(state, operand, &predicate);
+                        lai_exec_pop_opstack_back(state);
+
+                        if (predicate.integer) {
+                            item->cond_state = LAI_COND_BRANCH;
+                        } else {
+                            if (item->cond_has_else) {
+                                item->cond_state = LAI_COND_BRANCH;
+                                block->pc = item->cond_else_pc;
+                                block->limit = item->cond_else_limit;
+                            } else {
+                                lai_exec_pop_blkstack_back(state);
+                                lai_exec_pop_stack_back(state);
+                            }
+                        }
+                        continue;
+                    }
+                    if ((e = lai_exec_parse(LAI_OBJECT_MODE, state)))
+                        return e;
+                    continue;
                 } else {
-                    if (item->cond_has_else) {
-                        item->cond_state = LAI_COND_BRANCH;
-                        block->pc = item->cond_else_pc;
-                        block->limit = item->cond_else_limit;
-                    } else {
+                    LAI_ENSURE(item->cond_state == LAI_COND_BRANCH);
+                    if (block->pc == block->limit) {
                         lai_exec_pop_blkstack_back(state);
                         lai_exec_pop_stack_back(state);
+                        continue;
                     }
+                    if ((e = lai_exec_parse(LAI_EXEC_MODE, state)))
+                        return e;
+                    continue;
                 }
-                return LAI_ERROR_NONE;
-            } else {
-                return lai_exec_parse(LAI_OBJECT_MODE, state);
             }
-        } else {
-            LAI_ENSURE(item->cond_state == LAI_COND_BRANCH);
-            if (block->pc == block->limit) {
-                lai_exec_pop_blkstack_back(state);
-                lai_exec_pop_stack_back(state);
-                return LAI_ERROR_NONE;
-            } else {
-                return lai_exec_parse(LAI_EXEC_MODE, state);
-            }
-        }
-    } else if (item->kind == LAI_BANKFIELD_STACKITEM) {
-        int k = state->opstack_ptr - item->opstack_frame;
-        LAI_ENSURE(k <= 3);
-        if (k == 3) { // there's already region_name and bank_name on there
-            LAI_CLEANUP_VAR lai_variable_t bank_value_var = LAI_VAR_INITIALIZER;
-            struct lai_operand *operand;
-
-            operand = lai_exec_get_opstack(state, item->opstack_frame);
-            lai_nsnode_t *region_node = operand->handle;
-
-            operand = lai_exec_get_opstack(state, item->opstack_frame + 1);
-            lai_nsnode_t *bank_node = operand->handle;
-
-            operand = lai_exec_get_opstack(state, item->opstack_frame + 2);
-            lai_exec_get_integer(state, operand, &bank_value_var);
-            uint64_t bank_value = bank_value_var.integer;
-
-            lai_exec_pop_opstack(state, 3);
-
-            int pc = block->pc;
-
-            uint8_t access_type = *(method + pc);
-            pc++;
-
-            // parse FieldList
-            struct lai_amlname field_amln;
-            uint64_t curr_off = 0;
-            size_t skip_bits;
-            while (pc < block->limit) {
-                switch (*(method + pc)) {
-                    case 0: // ReservedField
-                        pc++;
-                        // TODO: Partially failing to parse a Field() is a bad idea.
-                        if (lai_parse_varint(&skip_bits, method, &pc, limit))
-                            return LAI_ERROR_EXECUTION_FAILURE;
-                        curr_off += skip_bits;
-                        break;
-                    case 1: // AccessField
-                        pc++;
-                        access_type = *(method + pc);
-                        pc += 2;
-                        break;
-                    case 2: // TODO: ConnectField
-                        lai_panic("ConnectField parsing isn't implemented");
-                        break;
-                    default: // NamedField
-                        // TODO: Partially failing to parse a Field() is a bad idea.
-                        if (lai_parse_name(&field_amln, method, &pc, limit)
-                            || lai_parse_varint(&skip_bits, method, &pc, limit))
-                            return LAI_ERROR_EXECUTION_FAILURE;
-
-                        lai_nsnode_t *node = lai_create_nsnode_or_die();
-                        node->type = LAI_NAMESPACE_BANK_FIELD;
-                        node->bkf_region_node = region_node;
-                        node->bkf_bank_node = bank_node;
-                        node->bkf_flags = access_type;
-                        node->bkf_size = skip_bits;
-                        node->bkf_offset = curr_off;
-                        node->bkf_value = bank_value;
-                        lai_do_resolve_new_node(node, ctx_handle, &field_amln);
-                        lai_install_nsnode(node);
-                        if (invocation)
-                            lai_list_link(&invocation->per_method_list, &node->per_method_item);
+            LAI_EXEC_TARGET(LAI_BANKFIELD_STACKITEM) {
+                int k = state->opstack_ptr - item->opstack_frame;
+                LAI_ENSURE(k <= 3);
+                if (k == 3) { // there's already region_name and bank_name on there
+                    LAI_CLEANUP_VAR lai_variable_t bank_value_var = LAI_VAR_INITIALIZER;
+                    struct lai_operand *operand;
+
+                    operand = lai_exec_get_opstack(state, item->opstack_frame);
+                    lai_nsnode_t *region_node = operand->handle;
+
+                    operand = lai_exec_get_opstack(state, item->opstack_frame + 1);
+                    lai_nsnode_t *bank_node = operand->handle;
+
+                    operand = lai_exec_get_opstack(state, item->opstack_frame + 2);
+                    lai_exec_get_integer(state, operand, &bank_value_var);
+                    uint64_t bank_value = bank_value_var.integer;
+
+                    lai_exec_pop_opstack(state, 3);
+
+                    int pc = block->pc;
+
+                    uint8_t access_type = *(method + pc);
+                    pc++;
+
+                    // parse FieldList
+                    struct lai_amlname field_amln;
+                    uint64_t curr_off = 0;
+                    size_t skip_bits;
+                    while (pc < block->limit) {
+                        switch (*(method + pc)) {
+                            case 0: // ReservedField
+                                pc++;
+                                // TODO: Partially failing to parse a Field() is a bad idea.
+                                if (lai_parse_varint(&skip_bits, method, &pc, limit))
+                                    return LAI_ERROR_EXECUTION_FAILURE;
+                                curr_off += skip_bits;
+                                break;
+                            case 1: // AccessField
+                                pc++;
+                                access_type = *(method + pc);
+                                pc += 2;
+                                break;
+                            case 2: // TODO: ConnectField
+                                lai_panic("ConnectField parsing isn't implemented");
+                                break;
+                            default: // NamedField
+                                // TODO: Partially failing to parse a Field() is a bad idea.
+                                if (lai_parse_name(&field_amln, method, &pc, limit)
+                                    || lai_parse_varint(&skip_bits, method, &pc, limit))
+                                    return LAI_ERROR_EXECUTION_FAILURE;
+
+                                lai_nsnode_t *node = lai_create_nsnode_or_die();
+                                node->type = LAI_NAMESPACE_BANK_FIELD;
+                                node->bkf = laihost_malloc(sizeof(struct lai_bank_field));
+                                if (!node->bkf)
+                                    lai_panic("could not allocate memory for BankField");
+                                node->bkf->region_node = region_node;
+                                node->bkf->bank_node = bank_node;
+                                node->bkf->flags = access_type;
+                                node->bkf->size = skip_bits;
+                                node->bkf->offset = curr_off;
+                                node->bkf->value = bank_value;
+                                lai_do_resolve_new_node(node, ctx_handle, &field_amln);
+                                lai_install_nsnode(node);
+                                if (invocation)
+                                    lai_list_link(&invocation->per_method_list,
+                                                  &node->per_method_item);
+
+                                curr_off += skip_bits;
+                        }
+                    }
 
-                        curr_off += skip_bits;
+                    lai_exec_pop_blkstack_back(state);
+                    lai_exec_pop_stack_back(state);
+                    continue;
                 }
+                if ((e = lai_exec_parse(LAI_OBJECT_MODE, state)))
+                    return e;
+                continue;
             }
-
-            lai_exec_pop_blkstack_back(state);
-            lai_exec_pop_stack_back(state);
-            return LAI_ERROR_NONE;
-        } else {
-            return lai_exec_parse(LAI_OBJECT_MODE, state);
+            LAI_EXEC_INVALID_TARGET
+                lai_panic("unexpected lai_stackitem_t");
         }
-    } else
-        lai_panic("unexpected lai_stackitem_t");
+    }
+
+    return 0;
 }
 
 static inline int lai_parse_u8(uint8_t *out, uint8_t *code, int *pc, int limit) {
@@ -1865,6 +2181,295 @@ static inline int lai_parse_u64(uint64_t *out, uint8_t *code, int *pc, int limit
     return 0;
 }
 
+struct lai_method_ir *lai_exec_create_ir(size_t size) {
+    // lai_method_ir::map stores 16-bit indices. As there is at most one instruction per
+    // byte of AML, this covers all but the largest methods.
+    if (!size || size >= 0xFFFF)
+        return NULL;
+
+    struct lai_method_ir *ir = laihost_malloc(sizeof(struct lai_method_ir));
+    if (!ir)
+        return NULL;
+    memset(ir, 0, sizeof(struct lai_method_ir));
+    ir->map = laihost_malloc(size * sizeof(uint16_t));
+    if (!ir->map) {
+        laihost_free(ir, sizeof(struct lai_method_ir));
+        return NULL;
+    }
+    memset(ir->map, 0, size * sizeof(uint16_t));
+    ir->size = size;
+    return ir;
+}
+
+void lai_exec_free_ir(struct lai_method_ir *ir) {
+    if (ir->insns)
+        laihost_free(ir->insns, ir->insns_capacity * sizeof(struct lai_ir_insn));
+    if (ir->names)
+        laihost_free(ir->names, ir->names_capacity * sizeof(struct lai_ir_name));
+    laihost_free(ir->map, ir->size * sizeof(uint16_t));
+    laihost_free(ir, sizeof(struct lai_method_ir));
+}
+
+// Checks whether the operands of an integer operator (starting at pc) can be evaluated by
+// lai_exec_int_op(). If so, the instruction is turned into a LAI_IR_INT_OP.
+static void lai_exec_decode_int_op(struct lai_ir_insn *insn, uint8_t *method, int pc,
+                                   int limit) {
+    int num_sources;
+    int num_operands;
+    switch (insn->opcode) {
+        case ADD_OP:
+        case SUBTRACT_OP:
+        case MULTIPLY_OP:
+        case AND_OP:
+        case OR_OP:
+        case XOR_OP:
+        case SHL_OP:
+        case SHR_OP:
+            num_sources = 2;
+            num_operands = 3;
+            break;
+        case LEQUAL_OP:
+        case LLESS_OP:
+        case LGREATER_OP:
+            num_sources = 2;
+            num_operands = 2;
+            break;
+        case INCREMENT_OP:
+        case DECREMENT_OP:
+            num_sources = 0;
+            num_operands = 1;
+            break;
+        default:
+            return;
+    }
+
+    int have_imm = 0;
+    for (int k = 0; k < num_operands; k++) {
+        if (pc >= limit)
+            return;
+        uint8_t opcode = method[pc++];
+        int is_slot = (opcode >= LOCAL0_OP && opcode <= LOCAL7_OP)
+                      || (opcode >= ARG0_OP && opcode <= ARG6_OP);
+        if (k >= num_sources) {
+            // Targets are ARGx, LOCALx or (except for Increment/Decrement) the null target.
+            if (!is_slot && !(opcode == ZERO_OP && num_sources))
+                return;
+        } else if (!is_slot && opcode != ZERO_OP && opcode != ONE_OP && opcode != ONES_OP) {
+            // Only a single constant with a prefix fits into the instruction.
+            if (have_imm)
+                return;
+            if (opcode == BYTEPREFIX) {
+                uint8_t temp;
+                if (lai_parse_u8(&temp, method, &pc, limit))
+                    return;
+                insn->imm = temp;
+            } else if (opcode == WORDPREFIX) {
+                uint16_t temp;
+                if (lai_parse_u16(&temp, method, &pc, limit))
+                    return;
+                insn->imm = temp;
+            } else if (opcode == DWORDPREFIX) {
+                if (lai_parse_u32(&insn->imm, method, &pc, limit))
+                    return;
+            } else {
+                return;
+            }
+            have_imm = 1;
+        }
+        insn->operands[k] = opcode;
+    }
+
+    insn->kind = LAI_IR_INT_OP;
+    insn->end_pc = pc;
+}
+
+// Decodes the instruction at pc: its opcode, PkgLength, immediate value or NameString.
+// Returns nonzero if the instruction extends beyond limit.
+static int lai_exec_decode(struct lai_ir_insn *insn, struct lai_amlname *amln, uint8_t *method,
+                           int pc, int limit) {
+    int opcode_pc = pc;
+
+    if (lai_is_name(method[pc])) {
+        if (lai_parse_name(amln, method, &pc, limit))
+            return 1;
+        insn->opcode = 0;
+        insn->kind = LAI_IR_NAME;
+        insn->has_else = 0;
+        insn->pc = pc;
+        insn->data_pc = pc;
+        insn->end_pc = pc;
+        insn->value = 0;
+        insn->name = LAI_IR_NO_SLOT;
+        return 0;
+    }
+
+    int opcode;
+    if (method[pc] == EXTOP_PREFIX) {
+        if (pc + 1 == limit)
+            lai_panic("two-byte opcode on method boundary");
+        opcode = (EXTOP_PREFIX << 8) | method[pc + 1];
+        pc += 2;
+    } else {
+        opcode = method[pc];
+        pc++;
+    }
+    insn->opcode = opcode;
+    insn->kind = LAI_IR_OPCODE;
+    insn->has_else = 0;
+    insn->pc = pc;
+    insn->value = 0;
+
+    switch (opcode) {
+        case BYTEPREFIX: {
+            uint8_t temp;
+            if (lai_parse_u8(&temp, method, &pc, limit))
+                return 1;
+            insn->value = temp;
+            break;
+        }
+        case WORDPREFIX: {
+            uint16_t temp;
+            if (lai_parse_u16(&temp, method, &pc, limit))
+                return 1;
+            insn->value = temp;
+            break;
+        }
+        case DWORDPREFIX: {
+            uint32_t temp;
+            if (lai_parse_u32(&temp, method, &pc, limit))
+                return 1;
+            insn->value = temp;
+            break;
+        }
+        case QWORDPREFIX:
+            if (lai_parse_u64(&insn->value, method, &pc, limit))
+                return 1;
+            break;
+        case STRINGPREFIX: {
+            size_t n = 0; // Length of null-terminated string.
+            while (pc + n < (size_t)limit && method[pc + n])
+                n++;
+            if (pc + n == (size_t)limit)
+                lai_panic("unterminated string in AML code");
+            pc += n + 1;
+            break;
+        }
+        case BUFFER_OP:
+        case PACKAGE_OP:
+        case VARPACKAGE_OP:
+        case WHILE_OP: {
+            size_t encoded_size;
+            if (lai_parse_varint(&encoded_size, method, &pc, limit))
+                return 1;
+            insn->data_pc = pc;
+            insn->end_pc = opcode_pc + 1 + encoded_size;
+            return 0;
+        }
+        case IF_OP: {
+            size_t if_size;
+            size_t else_size = 0;
+            if (lai_parse_varint(&if_size, method, &pc, limit))
+                return 1;
+            insn->data_pc = pc;
+            insn->end_pc = opcode_pc + 1 + if_size;
+            insn->else_pc = 0;
+
+            // The Else() belongs to the If(); it is never executed on its own.
+            pc = insn->end_pc;
+            if (pc < limit && method[pc] == ELSE_OP) {
+                insn->has_else = 1;
+                pc++;
+                if (lai_parse_varint(&else_size, method, &pc, limit))
+                    return 1;
+                insn->else_pc = pc;
+            }
+            insn->else_end_pc = opcode_pc + 1 + if_size + 1 + else_size;
+            return 0;
+        }
+    }
+
+    insn->data_pc = pc;
+    insn->end_pc = pc;
+    lai_exec_decode_int_op(insn, method, pc, limit);
+    return 0;
+}
+
+static void *lai_exec_ir_grow(void *array, size_t *capacity, size_t elem_size) {
+    size_t new_capacity = *capacity ? 2 * *capacity : 16;
+    void *new_array = laihost_realloc(array, new_capacity * elem_size, *capacity * elem_size);
+    if (!new_array)
+        return NULL;
+    *capacity = new_capacity;
+    return new_array;
+}
+
+// Adds a decoded instruction to the cache. If memory is exhausted, the instruction is
+// simply not cached.
+static void lai_exec_ir_insert(struct lai_method_ir *ir, int pc, struct lai_ir_insn *insn,
+                               const struct lai_amlname *amln) {
+    if (ir->num_insns == ir->insns_capacity) {
+        void *insns = lai_exec_ir_grow(ir->insns, &ir->insns_capacity, sizeof(struct lai_ir_insn));
+        if (!insns)
+            return;
+        ir->insns = insns;
+    }
+
+    if (insn->kind == LAI_IR_NAME) {
+        if (ir->num_names == ir->names_capacity) {
+            void *names
+                = lai_exec_ir_grow(ir->names, &ir->names_capacity, sizeof(struct lai_ir_name));
+            if (!names)
+                return;
+            ir->names = names;
+        }
+
+        struct lai_ir_name *slot = &ir->names[ir->num_names];
+        slot->amln = *amln;
+        slot->ctx_handle = NULL;
+        slot->node = NULL;
+        slot->generation = 0;
+        insn->name = ir->num_names++;
+    }
+
+    ir->insns[ir->num_insns++] = *insn;
+    ir->map[pc] = ir->num_insns;
+}
+
+// Returns the decoded instruction at pc; decodes it if it is not in the cache yet.
+// For names, *amln is set to the parsed NameString.
+static int lai_exec_fetch(struct lai_ir_insn *insn, struct lai_amlname *amln,
+                          struct lai_method_ir *ir, uint8_t *method, int pc, int limit) {
+    if (ir) {
+        uint16_t k = ir->map[pc];
+        if (k) {
+            *insn = ir->insns[k - 1];
+            if (insn->kind == LAI_IR_NAME)
+                *amln = ir->names[insn->name].amln;
+            return 0;
+        }
+    }
+
+    if (lai_exec_decode(insn, amln, method, pc, limit))
+        return 1;
+    if (ir)
+        lai_exec_ir_insert(ir, pc, insn, amln);
+    return 0;
+}
+
+// Like lai_do_resolve_cached(), but the cache entry is the slot of the decoded name.
+static lai_nsnode_t *lai_exec_resolve_ir(struct lai_method_ir *ir, uint32_t index,
+                                         lai_nsnode_t *ctx_handle) {
+    struct lai_ir_name *slot = &ir->names[index];
+    uint64_t generation = lai_current_instance()->ns_generation;
+    if (slot->generation == generation && slot->ctx_handle == ctx_handle)
+        return slot->node;
+
+    slot->node = lai_do_resolve(ctx_handle, &slot->amln);
+    slot->ctx_handle = ctx_handle;
+    slot->generation = generation;
+    return slot->node;
+}
+
 // Advances the PC of the current block.
 // lai_exec_parse() calls this function after successfully parsing a full opcode.
 // Even if parsing fails, this mechanism makes sure that the PC never points to
@@ -1876,6 +2481,192 @@ static inline void lai_exec_commit_pc(lai_state_t *state, int pc) {
     block->pc = pc;
 }
 
+// Operand modes of the operators that are evaluated by lai_exec_reduce_op().
+// The list of modes is terminated by zero; opcodes of other instructions have no modes.
+#define LAI_OP_MAX_MODES 8
+
+static const uint8_t lai_op_arg_modes[256][LAI_OP_MAX_MODES] = {
+    [TOBUFFER_OP] = {LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+    [TODECIMALSTRING_OP] = {LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+    [TOHEXSTRING_OP] = {LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+    [TOINTEGER_OP] = {LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+    [TOSTRING_OP] = {LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+    [MID_OP] = {LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+    [STORE_OP] = {LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+    [COPYOBJECT_OP] = {LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+    [NOT_OP] = {LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+    [FINDSETLEFTBIT_OP] = {LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+    [FINDSETRIGHTBIT_OP] = {LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+    [CONCAT_OP] = {LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+    [ADD_OP] = {LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+    [SUBTRACT_OP] = {LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+    [MOD_OP] = {LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+    [MULTIPLY_OP] = {LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+    [AND_OP] = {LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+    [OR_OP] = {LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+    [XOR_OP] = {LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+    [SHR_OP] = {LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+    [SHL_OP] = {LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+    [DIVIDE_OP] = {LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE, LAI_REFERENCE_MODE},
+    [INCREMENT_OP] = {LAI_REFERENCE_MODE},
+    [DECREMENT_OP] = {LAI_REFERENCE_MODE},
+    [LNOT_OP] = {LAI_OBJECT_MODE},
+    [LAND_OP] = {LAI_OBJECT_MODE, LAI_OBJECT_MODE},
+    [LOR_OP] = {LAI_OBJECT_MODE, LAI_OBJECT_MODE},
+    [LEQUAL_OP] = {LAI_OBJECT_MODE, LAI_OBJECT_MODE},
+    [LLESS_OP] = {LAI_OBJECT_MODE, LAI_OBJECT_MODE},
+    [LGREATER_OP] = {LAI_OBJECT_MODE, LAI_OBJECT_MODE},
+    [INDEX_OP] = {LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+    [MATCH_OP] = {LAI_OBJECT_MODE, LAI_IMMEDIATE_BYTE_MODE, LAI_OBJECT_MODE,
+                  LAI_IMMEDIATE_BYTE_MODE, LAI_OBJECT_MODE, LAI_OBJECT_MODE},
+    [CONCATRES_OP] = {LAI_OBJECT_MODE, LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+    [OBJECTTYPE_OP] = {LAI_REFERENCE_MODE},
+    [DEREF_OP] = {LAI_OBJECT_MODE},
+    [SIZEOF_OP] = {LAI_OBJECT_MODE},
+    [REFOF_OP] = {LAI_REFERENCE_MODE},
+    [NOTIFY_OP] = {LAI_REFERENCE_MODE, LAI_OBJECT_MODE},
+};
+
+// Same as lai_op_arg_modes, but for opcodes that follow EXTOP_PREFIX.
+static const uint8_t lai_extop_arg_modes[64][LAI_OP_MAX_MODES] = {
+    [FATAL_OP] = {LAI_IMMEDIATE_BYTE_MODE, LAI_IMMEDIATE_DWORD_MODE, LAI_OBJECT_MODE},
+    [CONDREF_OP] = {LAI_OPTIONAL_REFERENCE_MODE, LAI_REFERENCE_MODE},
+    [STALL_OP] = {LAI_OBJECT_MODE},
+    [SLEEP_OP] = {LAI_OBJECT_MODE},
+    [ACQUIRE_OP] = {LAI_REFERENCE_MODE, LAI_IMMEDIATE_WORD_MODE},
+    [RELEASE_OP] = {LAI_REFERENCE_MODE},
+    [WAIT_OP] = {LAI_REFERENCE_MODE, LAI_OBJECT_MODE},
+    [SIGNAL_OP] = {LAI_REFERENCE_MODE},
+    [RESET_OP] = {LAI_REFERENCE_MODE},
+    [FROM_BCD_OP] = {LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+    [TO_BCD_OP] = {LAI_OBJECT_MODE, LAI_REFERENCE_MODE},
+};
+
+// Returns the operand modes of an operator or NULL if the opcode is not an operator.
+static inline const uint8_t *lai_exec_op_arg_modes(int opcode) {
+    const uint8_t *modes;
+    if (opcode < 256)
+        modes = lai_op_arg_modes[opcode];
+    else if ((opcode >> 8) == EXTOP_PREFIX && (opcode & 0xFF) < 64)
+        modes = lai_extop_arg_modes[opcode & 0xFF];
+    else
+        return NULL;
+    if (!modes[0])
+        return NULL;
+    return modes;
+}
+
+// Helpers for lai_exec_int_op().
+static inline lai_variable_t *lai_exec_int_slot(struct lai_invocation *invocation,
+                                                uint8_t opcode) {
+    if (opcode >= ARG0_OP)
+        return &invocation->arg[opcode - ARG0_OP];
+    return &invocation->local[opcode - LOCAL0_OP];
+}
+
+static inline int lai_exec_int_load(struct lai_ir_insn *insn, struct lai_invocation *invocation,
+                                    int k, uint64_t *out) {
+    uint8_t opcode = insn->operands[k];
+    switch (opcode) {
+        case ZERO_OP:
+            *out = 0;
+            return 0;
+        case ONE_OP:
+            *out = 1;
+            return 0;
+        case ONES_OP:
+            *out = ~((uint64_t)0);
+            return 0;
+        case BYTEPREFIX:
+        case WORDPREFIX:
+        case DWORDPREFIX:
+            *out = insn->imm;
+            return 0;
+    }
+    lai_variable_t *var = lai_exec_int_slot(invocation, opcode);
+    if (var->type != LAI_INTEGER)
+        return 1;
+    *out = var->integer;
+    return 0;
+}
+
+// ARGx that contain references (and slots that contain other objects) are left
+// to lai_operand_mutate().
+static inline int lai_exec_int_store(struct lai_invocation *invocation, uint8_t opcode,
+                                     uint64_t value) {
+    if (opcode == ZERO_OP)
+        return 0;
+    lai_variable_t *var = lai_exec_int_slot(invocation, opcode);
+    if (var->type && var->type != LAI_INTEGER)
+        return 1;
+    var->type = LAI_INTEGER;
+    var->integer = value;
+    return 0;
+}
+
+// Evaluates a LAI_IR_INT_OP without pushing its operands to the opstack.
+// Returns nonzero (without side effects) if an operand is not an integer;
+// in this case, the instruction needs to be evaluated by lai_exec_reduce_op().
+static int lai_exec_int_op(struct lai_ir_insn *insn, struct lai_invocation *invocation,
+                           uint64_t *result) {
+    uint64_t lhs, rhs;
+    if (!invocation)
+        return 1;
+    if (lai_exec_int_load(insn, invocation, 0, &lhs))
+        return 1;
+
+    switch (insn->opcode) {
+        case INCREMENT_OP:
+            *result = lhs + 1;
+            return lai_exec_int_store(invocation, insn->operands[0], *result);
+        case DECREMENT_OP:
+            *result = lhs - 1;
+            return lai_exec_int_store(invocation, insn->operands[0], *result);
+    }
+
+    if (lai_exec_int_load(insn, invocation, 1, &rhs))
+        return 1;
+
+    switch (insn->opcode) {
+        case LEQUAL_OP:
+            *result = (lhs == rhs) ? ~((uint64_t)0) : 0;
+            return 0;
+        case LLESS_OP:
+            *result = (lhs < rhs) ? ~((uint64_t)0) : 0;
+            return 0;
+        case LGREATER_OP:
+            *result = (lhs > rhs) ? ~((uint64_t)0) : 0;
+            return 0;
+        case ADD_OP:
+            *result = lhs + rhs;
+            break;
+        case SUBTRACT_OP:
+            *result = lhs - rhs;
+            break;
+        case MULTIPLY_OP:
+            *result = lhs * rhs;
+            break;
+        case AND_OP:
+            *result = lhs & rhs;
+            break;
+        case OR_OP:
+            *result = lhs | rhs;
+            break;
+        case XOR_OP:
+            *result = lhs ^ rhs;
+            break;
+        case SHL_OP:
+            *result = lhs << rhs;
+            break;
+        case SHR_OP:
+            *result = lhs >> rhs;
+            break;
+        default:
+            return 1;
+    }
+    return lai_exec_int_store(invocation, insn->operands[2], *result);
+}
+
 static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
     struct lai_ctxitem *ctxitem = lai_exec_peek_ctxstack_back(state);
     struct lai_blkitem *block = lai_exec_peek_blkstack_back(state);
@@ -1885,6 +2676,7 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
     uint8_t *method = ctxitem->code;
     lai_nsnode_t *ctx_handle = ctxitem->handle;
     struct lai_invocation *invocation = ctxitem->invocation;
+    struct lai_method_ir *ir = ctxitem->ir;
     struct lai_instance *instance = lai_current_instance();
 
     int pc = block->pc;
@@ -1953,11 +2745,14 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
         return LAI_ERROR_NONE;
     }
 
+    struct lai_ir_insn insn;
+    struct lai_amlname amln;
+    if (lai_exec_fetch(&insn, &amln, ir, method, pc, limit))
+        return LAI_ERROR_EXECUTION_FAILURE;
+    pc = insn.pc;
+
     // Process names.
-    if (lai_is_name(method[pc])) {
-        struct lai_amlname amln;
-        if (lai_parse_name(&amln, method, &pc, limit))
-            return LAI_ERROR_EXECUTION_FAILURE;
+    if (insn.kind == LAI_IR_NAME) {
 
         if (lai_exec_reserve_opstack(state) || lai_exec_reserve_stack(state))
             return LAI_ERROR_OUT_OF_MEMORY;
@@ -1972,11 +2767,12 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
                 lai_debug("parsing name %s [@ 0x%x]", path, table_pc);
 
             if (want_result) {
+                lai_variable_t lazy = {0};
+                if (lai_exec_create_lazy_handle(&lazy, ctx_handle, method + opcode_pc))
+                    return LAI_ERROR_OUT_OF_MEMORY;
                 struct lai_operand *opstack_res = lai_exec_push_opstack(state);
                 opstack_res->tag = LAI_OPERAND_OBJECT;
-                opstack_res->object.type = LAI_LAZY_HANDLE;
-                opstack_res->object.unres_ctx_handle = ctx_handle;
-                opstack_res->object.unres_aml = method + opcode_pc;
+                opstack_res->object = lazy;
             }
         } else if (!(lai_mode_flags[parse_mode] & LAI_MF_RESOLVE)) {
             if (instance->trace & LAI_TRACE_OP)
@@ -1989,7 +2785,13 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
                 opstack_res->unres_aml = method + opcode_pc;
             }
         } else {
-            lai_nsnode_t *handle = lai_do_resolve(ctx_handle, &amln);
+            lai_nsnode_t *handle;
+            if (insn.name != LAI_IR_NO_SLOT)
+                handle = lai_exec_resolve_ir(ir, insn.name, ctx_handle);
+            else if (invocation)
+                handle = lai_do_resolve_cached(amls, ctx_handle, method + opcode_pc, &amln);
+            else
+                handle = lai_do_resolve(ctx_handle, &amln);
             if (!handle) {
                 if (lai_mode_flags[parse_mode] & LAI_MF_NULLABLE) {
                     if (instance->trace & LAI_TRACE_OP)
@@ -2046,30 +2848,58 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
     }
 
     /* General opcodes */
-    int opcode;
-    if (method[pc] == EXTOP_PREFIX) {
-        if (pc + 1 == block->limit)
-            lai_panic("two-byte opcode on method boundary");
-        opcode = (EXTOP_PREFIX << 8) | method[pc + 1];
-        pc += 2;
-    } else {
-        opcode = method[pc];
-        pc++;
-    }
+    int opcode = insn.opcode;
     if (instance->trace & LAI_TRACE_OP) {
         lai_debug("parsing opcode 0x%02x [0x%x @ %c%c%c%c %d]", opcode, table_pc,
                   amls->table->header.signature[0], amls->table->header.signature[1],
                   amls->table->header.signature[2], amls->table->header.signature[3], amls->index);
     }
 
-    // This switch handles the majority of all opcodes.
-    switch (opcode) {
-        case NOP_OP:
-            lai_exec_commit_pc(state, pc);
-            break;
+    // Integer operators on ARGx, LOCALx and constants do not need to go through the opstack.
+    if (insn.kind == LAI_IR_INT_OP
+        && (parse_mode == LAI_OBJECT_MODE || parse_mode == LAI_EXEC_MODE)
+        && !(instance->trace & LAI_TRACE_OP)) {
+        if (lai_exec_reserve_opstack(state))
+            return LAI_ERROR_OUT_OF_MEMORY;
 
-        case ZERO_OP:
-            if (lai_exec_reserve_opstack(state))
+        uint64_t value;
+        if (!lai_exec_int_op(&insn, invocation, &value)) {
+            lai_exec_commit_pc(state, insn.end_pc);
+
+            if (want_result) {
+                struct lai_operand *result = lai_exec_push_opstack(state);
+                result->tag = LAI_OPERAND_OBJECT;
+                result->object.type = LAI_INTEGER;
+                result->object.integer = value;
+            }
+            return LAI_ERROR_NONE;
+        }
+    }
+
+    // Operators only differ in the modes of their operands.
+    const uint8_t *arg_modes = lai_exec_op_arg_modes(opcode);
+    if (arg_modes) {
+        if (lai_exec_reserve_stack(state))
+            return LAI_ERROR_OUT_OF_MEMORY;
+        lai_exec_commit_pc(state, pc);
+
+        lai_stackitem_t *op_item = lai_exec_push_stack(state);
+        op_item->kind = LAI_OP_STACKITEM;
+        op_item->op_opcode = opcode;
+        op_item->opstack_frame = state->opstack_ptr;
+        op_item->op_arg_modes = arg_modes;
+        op_item->op_want_result = want_result;
+        return LAI_ERROR_NONE;
+    }
+
+    // This switch handles the majority of all other opcodes.
+    switch (opcode) {
+        case NOP_OP:
+            lai_exec_commit_pc(state, pc);
+            break;
+
+        case ZERO_OP:
+            if (lai_exec_reserve_opstack(state))
                 return LAI_ERROR_OUT_OF_MEMORY;
             lai_exec_commit_pc(state, pc);
 
@@ -2157,35 +2987,9 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
         case WORDPREFIX:
         case DWORDPREFIX:
         case QWORDPREFIX: {
-            uint64_t value = 0;
-            switch (opcode) {
-                case BYTEPREFIX: {
-                    uint8_t temp;
-                    if (lai_parse_u8(&temp, method, &pc, limit))
-                        return LAI_ERROR_EXECUTION_FAILURE;
-                    value = temp;
-                    break;
-                }
-                case WORDPREFIX: {
-                    uint16_t temp;
-                    if (lai_parse_u16(&temp, method, &pc, limit))
-                        return LAI_ERROR_EXECUTION_FAILURE;
-                    value = temp;
-                    break;
-                }
-                case DWORDPREFIX: {
-                    uint32_t temp;
-                    if (lai_parse_u32(&temp, method, &pc, limit))
-                        return LAI_ERROR_EXECUTION_FAILURE;
-                    value = temp;
-                    break;
-                }
-                case QWORDPREFIX: {
-                    if (lai_parse_u64(&value, method, &pc, limit))
-                        return LAI_ERROR_EXECUTION_FAILURE;
-                    break;
-                }
-            }
+            // lai_exec_decode() already parsed the value.
+            uint64_t value = insn.value;
+            pc = insn.data_pc;
 
             if (lai_exec_reserve_opstack(state))
                 return LAI_ERROR_OUT_OF_MEMORY;
@@ -2201,14 +3005,9 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
             break;
         }
         case STRINGPREFIX: {
-            int data_pc;
-            size_t n = 0; // Length of null-terminated string.
-            while (pc + n < (size_t)block->limit && method[pc + n])
-                n++;
-            if (pc + n == (size_t)block->limit)
-                lai_panic("unterminated string in AML code");
-            data_pc = pc;
-            pc += n + 1;
+            int data_pc = pc;
+            size_t n = insn.data_pc - pc - 1; // Length of null-terminated string.
+            pc = insn.data_pc;
 
             if (lai_exec_reserve_opstack(state))
                 return LAI_ERROR_OUT_OF_MEMORY;
@@ -2225,12 +3024,8 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
             break;
         }
         case BUFFER_OP: {
-            int data_pc;
-            size_t encoded_size; // Size of the buffer initializer.
-            if (lai_parse_varint(&encoded_size, method, &pc, limit))
-                return LAI_ERROR_EXECUTION_FAILURE;
-            data_pc = pc;
-            pc = opcode_pc + 1 + encoded_size;
+            int data_pc = insn.data_pc;
+            pc = insn.end_pc;
 
             if (lai_exec_reserve_blkstack(state) || lai_exec_reserve_stack(state))
                 return LAI_ERROR_OUT_OF_MEMORY;
@@ -2238,7 +3033,7 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
 
             struct lai_blkitem *blkitem = lai_exec_push_blkstack(state);
             blkitem->pc = data_pc;
-            blkitem->limit = opcode_pc + 1 + encoded_size;
+            blkitem->limit = insn.end_pc;
 
             lai_stackitem_t *buf_item = lai_exec_push_stack(state);
             buf_item->kind = LAI_BUFFER_STACKITEM;
@@ -2247,12 +3042,8 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
             break;
         }
         case VARPACKAGE_OP: {
-            int data_pc;
-            size_t encoded_size; // Size of the package initializer.
-            if (lai_parse_varint(&encoded_size, method, &pc, limit))
-                return LAI_ERROR_EXECUTION_FAILURE;
-            data_pc = pc;
-            pc = opcode_pc + 1 + encoded_size;
+            int data_pc = insn.data_pc;
+            pc = insn.end_pc;
 
             if (lai_exec_reserve_opstack(state) || lai_exec_reserve_blkstack(state)
                 || lai_exec_reserve_stack(state))
@@ -2263,7 +3054,7 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
 
             struct lai_blkitem *blkitem = lai_exec_push_blkstack(state);
             blkitem->pc = data_pc;
-            blkitem->limit = opcode_pc + 1 + encoded_size;
+            blkitem->limit = insn.end_pc;
 
             lai_stackitem_t *pkg_item = lai_exec_push_stack(state);
             pkg_item->kind = LAI_VARPACKAGE_STACKITEM;
@@ -2271,18 +3062,15 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
             pkg_item->pkg_index = 0;
             pkg_item->pkg_want_result = want_result;
             pkg_item->pkg_phase = 0;
+            pkg_item->pkg_block = NULL;
 
             struct lai_operand *opstack_pkg = lai_exec_push_opstack(state);
             opstack_pkg->tag = LAI_OPERAND_OBJECT;
             break;
         }
         case PACKAGE_OP: {
-            int data_pc;
-            size_t encoded_size; // Size of the package initializer.
-            if (lai_parse_varint(&encoded_size, method, &pc, limit))
-                return LAI_ERROR_EXECUTION_FAILURE;
-            data_pc = pc;
-            pc = opcode_pc + 1 + encoded_size;
+            int data_pc = insn.data_pc;
+            pc = insn.end_pc;
 
             if (lai_exec_reserve_opstack(state) || lai_exec_reserve_blkstack(state)
                 || lai_exec_reserve_stack(state))
@@ -2293,7 +3081,7 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
 
             struct lai_blkitem *blkitem = lai_exec_push_blkstack(state);
             blkitem->pc = data_pc;
-            blkitem->limit = opcode_pc + 1 + encoded_size;
+            blkitem->limit = insn.end_pc;
 
             lai_stackitem_t *pkg_item = lai_exec_push_stack(state);
             pkg_item->kind = LAI_PACKAGE_STACKITEM;
@@ -2301,6 +3089,7 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
             pkg_item->pkg_index = 0;
             pkg_item->pkg_want_result = want_result;
             pkg_item->pkg_phase = 0;
+            pkg_item->pkg_block = NULL;
 
             struct lai_operand *opstack_pkg = lai_exec_push_opstack(state);
             opstack_pkg->tag = LAI_OPERAND_OBJECT;
@@ -2321,12 +3110,8 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
         }
         /* While Loops */
         case WHILE_OP: {
-            int body_pc;
-            size_t loop_size;
-            if (lai_parse_varint(&loop_size, method, &pc, limit))
-                return LAI_ERROR_EXECUTION_FAILURE;
-            body_pc = pc;
-            pc = opcode_pc + 1 + loop_size;
+            int body_pc = insn.data_pc;
+            pc = insn.end_pc;
 
             if (lai_exec_reserve_blkstack(state) || lai_exec_reserve_stack(state))
                 return LAI_ERROR_OUT_OF_MEMORY;
@@ -2334,7 +3119,7 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
 
             struct lai_blkitem *blkitem = lai_exec_push_blkstack(state);
             blkitem->pc = body_pc;
-            blkitem->limit = opcode_pc + 1 + loop_size;
+            blkitem->limit = insn.end_pc;
 
             lai_stackitem_t *loop_item = lai_exec_push_stack(state);
             loop_item->kind = LAI_LOOP_STACKITEM;
@@ -2370,6 +3155,7 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
 
             // Keep the LAI_LOOP_STACKITEM but reset the PC.
             pc = loop_item->loop_pred;
+            lai_exec_trim_arena(state);
             break;
         }
         /* Break Loop */
@@ -2404,39 +3190,24 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
         }
         /* If/Else Conditional */
         case IF_OP: {
-            int if_pc = 0;
-            int else_pc = 0;
-            int has_else = 0;
-            size_t if_size = 0;
-            size_t else_size = 0;
-            if (lai_parse_varint(&if_size, method, &pc, limit))
-                return LAI_ERROR_EXECUTION_FAILURE;
-            if_pc = pc;
-            pc = opcode_pc + 1 + if_size;
-            if (pc < block->limit && method[pc] == ELSE_OP) {
-                has_else = 1;
-                pc++;
-                if (lai_parse_varint(&else_size, method, &pc, limit))
-                    return LAI_ERROR_EXECUTION_FAILURE;
-                else_pc = pc;
-                pc = opcode_pc + 1 + if_size + 1 + else_size;
-            }
+            // lai_exec_decode() also decodes the Else() that follows the If().
+            pc = insn.has_else ? insn.else_end_pc : insn.end_pc;
 
             if (lai_exec_reserve_blkstack(state) || lai_exec_reserve_stack(state))
                 return LAI_ERROR_OUT_OF_MEMORY;
             lai_exec_commit_pc(state, pc);
 
             struct lai_blkitem *blkitem = lai_exec_push_blkstack(state);
-            blkitem->pc = if_pc;
-            blkitem->limit = opcode_pc + 1 + if_size;
+            blkitem->pc = insn.data_pc;
+            blkitem->limit = insn.end_pc;
 
             lai_stackitem_t *cond_item = lai_exec_push_stack(state);
             cond_item->kind = LAI_COND_STACKITEM;
             cond_item->opstack_frame = state->opstack_ptr;
             cond_item->cond_state = 0;
-            cond_item->cond_has_else = has_else;
-            cond_item->cond_else_pc = else_pc;
-            cond_item->cond_else_limit = opcode_pc + 1 + if_size + 1 + else_size;
+            cond_item->cond_has_else = insn.has_else;
+            cond_item->cond_else_pc = insn.else_pc;
+            cond_item->cond_else_limit = insn.else_end_pc;
             break;
         }
         case ELSE_OP:
@@ -2905,11 +3676,14 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
 
                         lai_nsnode_t *node = lai_create_nsnode_or_die();
                         node->type = LAI_NAMESPACE_INDEXFIELD;
-                        node->idxf_index_node = index_node;
-                        node->idxf_data_node = data_node;
-                        node->idxf_flags = access_type;
-                        node->idxf_size = skip_bits;
-                        node->idxf_offset = curr_off;
+                        node->idxf = laihost_malloc(sizeof(struct lai_index_field));
+                        if (!node->idxf)
+                            lai_panic("could not allocate memory for IndexField");
+                        node->idxf->index_node = index_node;
+                        node->idxf->data_node = data_node;
+                        node->idxf->flags = access_type;
+                        node->idxf->size = skip_bits;
+                        node->idxf->offset = curr_off;
                         lai_do_resolve_new_node(node, ctx_handle, &field_amln);
                         lai_install_nsnode(node);
                         if (invocation)
@@ -3021,129 +3795,6 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
             break;
         }
 
-        case TOBUFFER_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[1] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[2] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-
-        case TODECIMALSTRING_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[1] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[2] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-
-        case TOHEXSTRING_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[1] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[2] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-
-        case TOINTEGER_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[1] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[2] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-
-        case TOSTRING_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[1] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[2] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[3] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-
-        case MID_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[1] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[2] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[3] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[4] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-
-        case (EXTOP_PREFIX << 8) | FATAL_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_IMMEDIATE_BYTE_MODE;
-            op_item->op_arg_modes[1] = LAI_IMMEDIATE_DWORD_MODE;
-            op_item->op_arg_modes[2] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[3] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-
         case (EXTOP_PREFIX << 8) | DEBUG_OP: {
             if (lai_exec_reserve_opstack(state))
                 return LAI_ERROR_OUT_OF_MEMORY;
@@ -3157,409 +3808,6 @@ static lai_api_error_t lai_exec_parse(int parse_mode, lai_state_t *state) {
             break;
         }
 
-        case STORE_OP:
-        case COPYOBJECT_OP:
-        case NOT_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[1] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[2] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-        case FINDSETLEFTBIT_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[1] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[2] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-        case FINDSETRIGHTBIT_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[1] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[2] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-        case CONCAT_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[1] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[2] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[3] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-        case ADD_OP:
-        case SUBTRACT_OP:
-        case MOD_OP:
-        case MULTIPLY_OP:
-        case AND_OP:
-        case OR_OP:
-        case XOR_OP:
-        case SHR_OP:
-        case SHL_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[1] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[2] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[3] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-        case DIVIDE_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[1] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[2] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[3] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[4] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-
-        case INCREMENT_OP:
-        case DECREMENT_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[1] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-
-        case LNOT_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[1] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-        case LAND_OP:
-        case LOR_OP:
-        case LEQUAL_OP:
-        case LLESS_OP:
-        case LGREATER_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[1] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[2] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-
-        case INDEX_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[1] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[2] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[3] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-        case MATCH_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[1] = LAI_IMMEDIATE_BYTE_MODE;
-            op_item->op_arg_modes[2] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[3] = LAI_IMMEDIATE_BYTE_MODE;
-            op_item->op_arg_modes[4] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[5] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[6] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-        case CONCATRES_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[1] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[2] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[3] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-        case OBJECTTYPE_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[1] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-        case DEREF_OP:
-        case SIZEOF_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[1] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-        case REFOF_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[1] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-
-        case NOTIFY_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[1] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[2] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-
-        case (EXTOP_PREFIX << 8) | CONDREF_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_OPTIONAL_REFERENCE_MODE;
-            op_item->op_arg_modes[1] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[2] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-
-        case (EXTOP_PREFIX << 8) | STALL_OP:
-        case (EXTOP_PREFIX << 8) | SLEEP_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[1] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-
-        case (EXTOP_PREFIX << 8) | ACQUIRE_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[1] = LAI_IMMEDIATE_WORD_MODE;
-            op_item->op_arg_modes[2] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-        case (EXTOP_PREFIX << 8) | RELEASE_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[1] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-
-        case (EXTOP_PREFIX << 8) | WAIT_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[1] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[2] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-        case (EXTOP_PREFIX << 8) | SIGNAL_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[1] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-        case (EXTOP_PREFIX << 8) | RESET_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[1] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-
-        case (EXTOP_PREFIX << 8) | FROM_BCD_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[1] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[2] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-        case (EXTOP_PREFIX << 8) | TO_BCD_OP: {
-            if (lai_exec_reserve_stack(state))
-                return LAI_ERROR_OUT_OF_MEMORY;
-            lai_exec_commit_pc(state, pc);
-
-            lai_stackitem_t *op_item = lai_exec_push_stack(state);
-            op_item->kind = LAI_OP_STACKITEM;
-            op_item->op_opcode = opcode;
-            op_item->opstack_frame = state->opstack_ptr;
-            op_item->op_arg_modes[0] = LAI_OBJECT_MODE;
-            op_item->op_arg_modes[1] = LAI_REFERENCE_MODE;
-            op_item->op_arg_modes[2] = 0;
-            op_item->op_want_result = want_result;
-            break;
-        }
-
         default:
             lai_panic("unexpected opcode in lai_exec_run(), sequence %02X %02X %02X %02X",
                       method[opcode_pc + 0], method[opcode_pc + 1], method[opcode_pc + 2],
@@ -3597,14 +3845,17 @@ lai_api_error_t lai_populate(lai_nsnode_t *parent, struct lai_aml_segment *amls,
     return LAI_ERROR_NONE;
 }
 
-// lai_eval_args(): Evaluates a node of the ACPI namespace (including control methods).
-lai_api_error_t lai_eval_args(lai_variable_t *result, lai_nsnode_t *handle, lai_state_t *state,
-                              int n, lai_variable_t *args) {
+// lai_eval_move_args(): Evaluates a node of the ACPI namespace (including control methods).
+//                       The arguments are moved into the invocation of the method.
+lai_api_error_t lai_eval_move_args(lai_variable_t *result, lai_nsnode_t *handle,
+                                   lai_state_t *state, int n, lai_variable_t *args) {
     LAI_ENSURE(handle);
     LAI_ENSURE(handle->type != LAI_NAMESPACE_ALIAS);
 
     switch (handle->type) {
         case LAI_NAMESPACE_NAME:
+            for (int i = 0; i < n; i++)
+                lai_var_finalize(&args[i]);
             if (n) {
                 lai_warn("non-empty argument list given when evaluating Name()");
                 return LAI_ERROR_TYPE_MISMATCH;
@@ -3614,15 +3865,21 @@ lai_api_error_t lai_eval_args(lai_variable_t *result, lai_nsnode_t *handle, lai_
             return LAI_ERROR_NONE;
         case LAI_NAMESPACE_METHOD: {
             if (lai_exec_reserve_ctxstack(state) || lai_exec_reserve_blkstack(state)
-                || lai_exec_reserve_stack(state))
+                || lai_exec_reserve_stack(state)) {
+                for (int i = 0; i < n; i++)
+                    lai_var_finalize(&args[i]);
                 return LAI_ERROR_OUT_OF_MEMORY;
+            }
 
             LAI_CLEANUP_VAR lai_variable_t method_result = LAI_VAR_INITIALIZER;
             int e;
-            if (handle->method_override) {
+            struct lai_nsnode_overrides *overrides = lai_ns_get_overrides(handle);
+            if (overrides && overrides->method_override) {
                 // It's an OS-defined method.
                 // TODO: Verify the number of argument to the overridden method.
-                e = handle->method_override(args, &method_result);
+                e = overrides->method_override(args, &method_result);
+                for (int i = 0; i < n; i++)
+                    lai_var_finalize(&args[i]);
             } else {
                 // It's an AML method.
                 LAI_ENSURE(handle->amls);
@@ -3631,14 +3888,13 @@ lai_api_error_t lai_eval_args(lai_variable_t *result, lai_nsnode_t *handle, lai_
                 method_ctxitem->amls = handle->amls;
                 method_ctxitem->code = handle->pointer;
                 method_ctxitem->handle = handle;
-                method_ctxitem->invocation = laihost_malloc(sizeof(struct lai_invocation));
+                method_ctxitem->invocation = lai_exec_alloc_invocation(state);
                 if (!method_ctxitem->invocation)
                     lai_panic("could not allocate memory for method invocation");
-                memset(method_ctxitem->invocation, 0, sizeof(struct lai_invocation));
-                lai_list_init(&method_ctxitem->invocation->per_method_list);
+                method_ctxitem->ir = lai_get_method_ir(handle);
 
                 for (int i = 0; i < n; i++)
-                    lai_var_assign(&method_ctxitem->invocation->arg[i], &args[i]);
+                    lai_var_move(&method_ctxitem->invocation->arg[i], &args[i]);
 
                 struct lai_blkitem *blkitem = lai_exec_push_blkstack(state);
                 blkitem->pc = 0;
@@ -3656,11 +3912,13 @@ lai_api_error_t lai_eval_args(lai_variable_t *result, lai_nsnode_t *handle, lai_
                     if (state->opstack_ptr != 1) // This would be an internal error.
                         lai_panic("expected exactly one return value after method invocation");
                     struct lai_operand *opstack_top = lai_exec_get_opstack(state, 0);
-                    lai_variable_t objectref = {0};
-                    lai_exec_get_objectref(state, opstack_top, &objectref);
-                    lai_obj_clone(&method_result, &objectref);
-                    lai_var_finalize(&objectref);
+                    LAI_ENSURE(opstack_top->tag == LAI_OPERAND_OBJECT);
+                    lai_exec_move_result(&method_result, &opstack_top->object);
                     lai_exec_pop_opstack(state, 1);
+
+                    // All temporaries of the evaluation are dead, except for the result.
+                    lai_exec_promote(&method_result);
+                    lai_exec_reset_arena(state);
                 }
             }
             if (!e && result)
@@ -3669,10 +3927,24 @@ lai_api_error_t lai_eval_args(lai_variable_t *result, lai_nsnode_t *handle, lai_
         }
 
         default:
+            for (int i = 0; i < n; i++)
+                lai_var_finalize(&args[i]);
             return LAI_ERROR_TYPE_MISMATCH;
     }
 }
 
+// lai_eval_args(): Like lai_eval_move_args(), but the caller keeps its arguments.
+lai_api_error_t lai_eval_args(lai_variable_t *result, lai_nsnode_t *handle, lai_state_t *state,
+                              int n, lai_variable_t *args) {
+    LAI_ENSURE(n <= 7 && "ACPI supports at most 7 arguments");
+    lai_variable_t copies[7];
+    memset(copies, 0, sizeof(lai_variable_t) * 7);
+    for (int i = 0; i < n; i++)
+        lai_var_assign(&copies[i], &args[i]);
+
+    return lai_eval_move_args(result, handle, state, n, copies);
+}
+
 lai_api_error_t lai_eval_vargs(lai_variable_t *result, lai_nsnode_t *handle, lai_state_t *state,
                                va_list vl) {
     int n = 0;
@@ -3687,7 +3959,7 @@ lai_api_error_t lai_eval_vargs(lai_variable_t *result, lai_nsnode_t *handle, lai
         lai_var_assign(&args[n++], object);
     }
 
-    return lai_eval_args(result, handle, state, n, args);
+    return lai_eval_move_args(result, handle, state, n, args);
 }
 
 lai_api_error_t lai_eval_largs(lai_variable_t *result, lai_nsnode_t *handle, lai_state_t *state,
@@ -9,6 +9,9 @@
 
 #include <lai/core.h>
 
+#include "slab.h"
+#include "util-list.h"
+
 struct lai_amlname {
     int is_absolute; // Is the path absolute or not?
     int height; // Number of scopes to exit before resolving the name.
@@ -37,6 +40,8 @@ char *lai_stringify_amlname(const struct lai_amlname *amln);
 
 // This will replace lai_resolve().
 lai_nsnode_t *lai_do_resolve(lai_nsnode_t *ctx_handle, const struct lai_amlname *amln);
+lai_nsnode_t *lai_do_resolve_cached(struct lai_aml_segment *amls, lai_nsnode_t *ctx_handle,
+                                    const uint8_t *aml, const struct lai_amlname *amln);
 
 // Used in the implementation of lai_resolve_new_node().
 void lai_do_resolve_new_node(lai_nsnode_t *node, lai_nsnode_t *ctx_handle,
@@ -97,6 +102,152 @@ void lai_operand_emplace(lai_state_t *, struct lai_operand *, lai_variable_t *);
 void lai_exec_get_objectref(lai_state_t *, struct lai_operand *, lai_variable_t *);
 void lai_exec_get_integer(lai_state_t *, struct lai_operand *, lai_variable_t *);
 
+// --------------------------------------------------------------------------------------
+// Copy-on-write of strings, buffers and packages.
+// --------------------------------------------------------------------------------------
+
+// Drop a reference to a head. The head (and its content) is freed once it is unused.
+void lai_exec_unref_string(struct lai_string_head *head);
+void lai_exec_unref_buffer(struct lai_buffer_head *head);
+void lai_exec_unref_pkg(struct lai_pkg_head *head);
+
+void lai_exec_unshare_string_slow(struct lai_string_head *head);
+void lai_exec_unshare_buffer_slow(struct lai_buffer_head *head);
+void lai_exec_unshare_pkg_slow(struct lai_pkg_head *head);
+
+// Must be called before the content of a head is modified.
+static inline void lai_exec_unshare_string(struct lai_string_head *head) {
+    if (head->shared)
+        lai_exec_unshare_string_slow(head);
+}
+
+static inline void lai_exec_unshare_buffer(struct lai_buffer_head *head) {
+    if (head->shared)
+        lai_exec_unshare_buffer_slow(head);
+}
+
+static inline void lai_exec_unshare_pkg(struct lai_pkg_head *head) {
+    if (head->shared)
+        lai_exec_unshare_pkg_slow(head);
+}
+
+// Allocates a block with room for num_pkgs packages with num_elems elements in total.
+struct lai_pkg_block *lai_exec_alloc_pkg_block(size_t num_pkgs, size_t num_elems);
+// Creates a package in a block. Returns nonzero if the block is too small.
+int lai_exec_create_pkg_in_block(lai_variable_t *object, struct lai_pkg_block *block, size_t n);
+// Releases the memory of the elements of a package (without finalizing them).
+void lai_exec_release_pkg_elems(struct lai_pkg_head *head);
+// Creates a LAI_LAZY_HANDLE for the name at aml.
+lai_api_error_t lai_exec_create_lazy_handle(lai_variable_t *object, lai_nsnode_t *ctx_handle,
+                                            const uint8_t *aml);
+
+// --------------------------------------------------------------------------------------
+// Arena for temporaries.
+// --------------------------------------------------------------------------------------
+
+// Each object in the arena is preceded by a pointer to its chunk.
+#define LAI_ARENA_ALIGN 16
+
+// Allocates memory that is valid until the end of the current evaluation (or until it is
+// released by lai_exec_arena_free()).
+// Returns NULL if the arena cannot satisfy the allocation; callers fall back to the heap.
+void *lai_exec_arena_alloc(lai_state_t *state, size_t size);
+
+// Releases memory that was allocated by lai_exec_arena_alloc(). The memory is reused once
+// all objects of its chunk are released.
+static inline void lai_exec_arena_free(void *ptr) {
+    struct lai_arena_chunk *chunk = *(struct lai_arena_chunk **)((uint8_t *)ptr - LAI_ARENA_ALIGN);
+    LAI_ENSURE(chunk->live);
+    chunk->live--;
+}
+
+// Like lai_create_string() and lai_create_buffer(), but take the content from the arena
+// of state (if state is not NULL).
+lai_api_error_t lai_exec_create_string(lai_state_t *state, lai_variable_t *object,
+                                       size_t length);
+lai_api_error_t lai_exec_create_buffer(lai_state_t *state, lai_variable_t *object, size_t size);
+
+// Like the lai_obj_to_*() functions, but the result is a temporary of state.
+lai_api_error_t lai_exec_obj_to_buffer(lai_state_t *state, lai_variable_t *out,
+                                       lai_variable_t *object);
+lai_api_error_t lai_exec_obj_to_string(lai_state_t *state, lai_variable_t *out,
+                                       lai_variable_t *object, size_t size);
+lai_api_error_t lai_exec_obj_to_decimal_string(lai_state_t *state, lai_variable_t *out,
+                                               lai_variable_t *object);
+lai_api_error_t lai_exec_obj_to_hex_string(lai_state_t *state, lai_variable_t *out,
+                                           lai_variable_t *object);
+
+// Moves the content of an object (and of all package elements) out of the arena.
+// Must be called before an object is stored to a location that outlives the evaluation.
+void lai_exec_promote(lai_variable_t *object);
+
+// Moves a return value from source to dest; source is reset. Objects whose heads are also
+// referenced elsewhere (e.g., by a Name()) are cloned instead, such that modifications of
+// the result do not affect the other references.
+void lai_exec_move_result(lai_variable_t *dest, lai_variable_t *source);
+
+// --------------------------------------------------------------------------------------
+// Pre-decoded instructions of control methods.
+// --------------------------------------------------------------------------------------
+
+#define LAI_IR_OPCODE 1
+#define LAI_IR_NAME 2
+// Integer operator whose operands are all ARGx, LOCALx or constants, see lai_exec_int_op().
+#define LAI_IR_INT_OP 3
+
+#define LAI_IR_NO_SLOT 0xFFFFFFFF
+
+// An instruction of a method body, decoded by lai_exec_decode().
+struct lai_ir_insn {
+    uint16_t opcode; // Includes EXTOP_PREFIX for two-byte opcodes.
+    uint8_t kind;
+    uint8_t has_else; // If() that is followed by an Else().
+    int pc; // PC after the opcode (or after the NameString).
+    int data_pc; // PC after the PkgLength, immediate value or string.
+    int end_pc; // End of the PkgLength-encoded part (or of the operands of LAI_IR_INT_OP).
+    union {
+        uint64_t value; // Immediate integers.
+        struct { // IF_OP.
+            int else_pc;
+            int else_end_pc;
+        };
+        struct { // LAI_IR_INT_OP.
+            uint32_t imm; // Value of the (only) ByteConst, WordConst or DWordConst operand.
+            uint8_t operands[3]; // Opcodes of the operands, including the target.
+        };
+        uint32_t name; // Index into lai_method_ir::names or LAI_IR_NO_SLOT.
+    };
+};
+
+// A NameString of a method body, together with the node that it resolved to.
+struct lai_ir_name {
+    struct lai_amlname amln;
+    lai_nsnode_t *ctx_handle;
+    lai_nsnode_t *node; // Can be NULL if the name does not exist.
+    // The node is only valid if this matches lai_instance::ns_generation.
+    uint64_t generation;
+};
+
+// Instructions of a method are decoded when they are first executed;
+// further executions take the decoded instructions from this cache.
+struct lai_method_ir {
+    // Maps each PC of the method body to (1 + index into insns); 0 if not decoded yet.
+    uint16_t *map;
+    size_t size;
+
+    struct lai_ir_insn *insns;
+    size_t num_insns;
+    size_t insns_capacity;
+
+    struct lai_ir_name *names;
+    size_t num_names;
+    size_t names_capacity;
+};
+
+// Returns NULL if the method is too large to be cached or if allocation fails.
+struct lai_method_ir *lai_exec_create_ir(size_t size);
+void lai_exec_free_ir(struct lai_method_ir *ir);
+
 // --------------------------------------------------------------------------------------
 // Synchronization functions.
 // --------------------------------------------------------------------------------------
@@ -259,17 +410,39 @@ static inline struct lai_ctxitem *lai_exec_peek_ctxstack_back(lai_state_t *state
     return &state->ctxstack_base[state->ctxstack_ptr];
 }
 
+// Returns an invocation frame with cleared arguments and locals.
+// Frames are recycled through the state's free list; only calls that nest deeper than
+// all previous calls on the same state allocate memory.
+static inline struct lai_invocation *lai_exec_alloc_invocation(lai_state_t *state) {
+    struct lai_invocation *invocation = state->free_invocations;
+    if (invocation) {
+        // lai_exec_free_invocation() already cleared the frame.
+        state->free_invocations = invocation->next_free;
+    } else {
+        invocation = lai_slab_alloc(LAI_SLAB_INVOCATION);
+        if (!invocation)
+            return NULL;
+        memset(invocation, 0, sizeof(struct lai_invocation));
+    }
+    lai_list_init(&invocation->per_method_list);
+    return invocation;
+}
+
+static inline void lai_exec_free_invocation(lai_state_t *state, struct lai_invocation *invocation) {
+    for (int i = 0; i < 7; i++)
+        lai_var_finalize(&invocation->arg[i]);
+    for (int i = 0; i < 8; i++)
+        lai_var_finalize(&invocation->local[i]);
+    invocation->next_free = state->free_invocations;
+    state->free_invocations = invocation;
+}
+
 // Removes an item from the context stack.
 static inline void lai_exec_pop_ctxstack_back(lai_state_t *state) {
     LAI_ENSURE(state->ctxstack_ptr >= 0);
     struct lai_ctxitem *ctxitem = &state->ctxstack_base[state->ctxstack_ptr];
-    if (ctxitem->invocation) {
-        for (int i = 0; i < 7; i++)
-            lai_var_finalize(&ctxitem->invocation->arg[i]);
-        for (int i = 0; i < 8; i++)
-            lai_var_finalize(&ctxitem->invocation->local[i]);
-        laihost_free(ctxitem->invocation, sizeof(*ctxitem->invocation));
-    }
+    if (ctxitem->invocation)
+        lai_exec_free_invocation(state, ctxitem->invocation);
     state->ctxstack_ptr -= 1;
 }
 
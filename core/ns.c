@@ -12,6 +12,7 @@
 #include "exec_impl.h"
 #include "libc.h"
 #include "ns_impl.h"
+#include "slab.h"
 #include "util-hash.h"
 
 static int debug_resolution = 0;
@@ -20,31 +21,73 @@ int lai_do_osi_method(lai_variable_t *args, lai_variable_t *result);
 int lai_do_os_method(lai_variable_t *args, lai_variable_t *result);
 int lai_do_rev_method(lai_variable_t *args, lai_variable_t *result);
 
-static struct lai_aml_segment *lai_load_table(void *ptr, int index);
-
 struct lai_instance *lai_current_instance() {
     static struct lai_instance global_instance;
     return &global_instance;
 }
 
-static unsigned int lai_hash_string(const char *str, size_t n) {
-    // Simple djb2 hash function. TODO: Replace by SipHash for DoS resilience.
-    unsigned int x = 5381;
-    for (size_t i = 0; i < n; i++)
-        x = ((x << 5) + x) + str[i];
-    return x;
+// Children are indexed by their NameSeg, interpreted as a 32-bit integer.
+static inline uint32_t lai_ns_name_key(const char *name) {
+    uint32_t key;
+    memcpy(&key, name, 4);
+    return key;
 }
 
 lai_nsnode_t *lai_create_nsnode(void) {
-    lai_nsnode_t *node = laihost_malloc(sizeof(lai_nsnode_t));
+    lai_nsnode_t *node = lai_slab_alloc(LAI_SLAB_NSNODE);
     if (!node)
         return NULL;
-    // here we assume that the host does not return zeroed memory,
-    // so lai must zero the returned memory itself.
+    // The slab allocator does not return zeroed memory.
     memset(node, 0, sizeof(lai_nsnode_t));
     return node;
 }
 
+// Most nodes never get children, overrides or decoded instructions; only allocate
+// lai_nsnode_ext on demand.
+static struct lai_nsnode_ext *lai_get_ext(lai_nsnode_t *node) {
+    if (!node->ext) {
+        node->ext = laihost_malloc(sizeof(struct lai_nsnode_ext));
+        if (!node->ext)
+            lai_panic("could not allocate memory for struct lai_nsnode_ext");
+        memset(node->ext, 0, sizeof(struct lai_nsnode_ext));
+    }
+    return node->ext;
+}
+
+// Frees lai_nsnode_ext once it is unused.
+static void lai_put_ext(lai_nsnode_t *node) {
+    struct lai_nsnode_ext *ext = node->ext;
+    // lai_hashtable_remove() already freed the slots of empty tables.
+    if (ext->children.num_elems || ext->overrides || ext->ir)
+        return;
+    laihost_free(ext, sizeof(struct lai_nsnode_ext));
+    node->ext = NULL;
+}
+
+// Returns the overrides of a node, allocating them if necessary.
+struct lai_nsnode_overrides *lai_get_overrides(lai_nsnode_t *node) {
+    struct lai_nsnode_ext *ext = lai_get_ext(node);
+    if (!ext->overrides) {
+        ext->overrides = laihost_malloc(sizeof(struct lai_nsnode_overrides));
+        if (!ext->overrides)
+            lai_panic("could not allocate memory for node overrides");
+        memset(ext->overrides, 0, sizeof(struct lai_nsnode_overrides));
+    }
+    return ext->overrides;
+}
+
+struct lai_method_ir *lai_get_method_ir(lai_nsnode_t *node) {
+    LAI_ENSURE(node->type == LAI_NAMESPACE_METHOD);
+    if (node->ext && node->ext->ir)
+        return node->ext->ir;
+
+    struct lai_method_ir *ir = lai_exec_create_ir(node->size);
+    if (!ir)
+        return NULL;
+    lai_get_ext(node)->ir = ir;
+    return ir;
+}
+
 lai_nsnode_t *lai_create_nsnode_or_die(void) {
     lai_nsnode_t *node = lai_create_nsnode();
     if (!node)
@@ -52,6 +95,32 @@ lai_nsnode_t *lai_create_nsnode_or_die(void) {
     return node;
 }
 
+// Removes all free slots from ns_array. Nodes keep their relative order.
+// This renumbers nodes, so it must not run while the host might be in lai_ns_iterate().
+static void lai_compact_ns_array(void) {
+    struct lai_instance *instance = lai_current_instance();
+
+    size_t n = 0;
+    for (size_t i = 0; i < instance->ns_size; i++) {
+        lai_nsnode_t *node = instance->ns_array[i];
+        if (!node)
+            continue;
+        node->ns_index = n;
+        instance->ns_array[n++] = node;
+    }
+
+    instance->ns_size = n;
+    instance->ns_num_free = 0;
+}
+
+// Whether installing or uninstalling the node changes the device index (see devices.c).
+// Methods create and destroy temporary nodes all the time; most of them do not matter.
+static int lai_ns_affects_device_index(lai_nsnode_t *node) {
+    if (node->type == LAI_NAMESPACE_DEVICE)
+        return 1;
+    return !memcmp(node->name, "_HID", 4) || !memcmp(node->name, "_CID", 4);
+}
+
 // Installs the nsnode to the namespace.
 void lai_install_nsnode(lai_nsnode_t *node) {
     struct lai_instance *instance = lai_current_instance();
@@ -61,70 +130,121 @@ void lai_install_nsnode(lai_nsnode_t *node) {
         lai_debug("lai_install_nsnode: adding node with type %d at %s", node->type, fullpath);
     }
 
-    if (instance->ns_size == instance->ns_capacity) {
-        size_t new_capacity = instance->ns_capacity * 2;
-        if (!new_capacity)
-            new_capacity = 128;
-        lai_nsnode_t **new_array;
-        new_array = laihost_realloc(instance->ns_array, sizeof(lai_nsnode_t *) * new_capacity,
-                                    sizeof(lai_nsnode_t *) * instance->ns_capacity);
-        if (!new_array)
-            lai_panic("could not reallocate namespace table");
-        instance->ns_array = new_array;
-        instance->ns_capacity = new_capacity;
+    if (instance->ns_num_free) {
+        // Reuse a slot that was freed by lai_uninstall_nsnode().
+        size_t index = instance->ns_free_slots[--instance->ns_num_free];
+        LAI_ENSURE(!instance->ns_array[index]);
+        instance->ns_array[index] = node;
+        node->ns_index = index;
+    } else {
+        if (instance->ns_size == instance->ns_capacity) {
+            size_t new_capacity = instance->ns_capacity * 2;
+            if (!new_capacity)
+                new_capacity = 128;
+            lai_nsnode_t **new_array;
+            new_array = laihost_realloc(instance->ns_array, sizeof(lai_nsnode_t *) * new_capacity,
+                                        sizeof(lai_nsnode_t *) * instance->ns_capacity);
+            if (!new_array)
+                lai_panic("could not reallocate namespace table");
+            instance->ns_array = new_array;
+            instance->ns_capacity = new_capacity;
+        }
+
+        node->ns_index = instance->ns_size;
+        instance->ns_array[instance->ns_size++] = node;
     }
 
-    instance->ns_array[instance->ns_size++] = node;
+    // Invalidate the lai_resolve_path() cache.
+    instance->ns_generation++;
+    if (lai_ns_affects_device_index(node))
+        instance->device_generation++;
 
-    // Insert the node into its parent's hash table.
+    // Insert the node into its parent's hash table and append it to the list of children.
     lai_nsnode_t *parent = node->parent;
     if (parent) {
-        int h = lai_hash_string(node->name, 4);
-
-        struct lai_hashtable_chain chain = LAI_HASHTABLE_CHAIN_INITIALIZER;
-        while (!lai_hashtable_chain_advance(&parent->children, h, &chain)) {
-            lai_nsnode_t *child = lai_hashtable_chain_get(&parent->children, h, &chain);
-            if (!memcmp(child->name, node->name, 4)) {
-                LAI_CLEANUP_FREE_STRING char *fullpath = lai_stringify_node_path(node);
-                lai_panic("trying to install duplicate namespace node %s", fullpath);
-            }
+        struct lai_nsnode_ext *ext = lai_get_ext(parent);
+        uint32_t key = lai_ns_name_key(node->name);
+        if (lai_hashtable_find(&ext->children, key)) {
+            LAI_CLEANUP_FREE_STRING char *fullpath = lai_stringify_node_path(node);
+            lai_panic("trying to install duplicate namespace node %s", fullpath);
         }
 
-        lai_hashtable_insert(&parent->children, h, node);
+        lai_hashtable_insert(&ext->children, key, node);
+
+        node->next_sibling = NULL;
+        node->prev_sibling = ext->last_child;
+        if (ext->last_child)
+            ext->last_child->next_sibling = node;
+        else
+            ext->first_child = node;
+        ext->last_child = node;
     }
 }
 
 void lai_uninstall_nsnode(lai_nsnode_t *node) {
     struct lai_instance *instance = lai_current_instance();
 
-    for (size_t i = 0; i < instance->ns_size; i++) {
-        if (instance->ns_array[i] == node)
-            instance->ns_array[i] = NULL;
+    LAI_ENSURE(node->ns_index < instance->ns_size);
+    LAI_ENSURE(instance->ns_array[node->ns_index] == node);
+    instance->ns_array[node->ns_index] = NULL;
+
+    // Methods that are created by other methods are uninstalled once the creator returns;
+    // at that point, no invocation of the method can be running anymore.
+    if (node->ext && node->ext->ir) {
+        lai_exec_free_ir(node->ext->ir);
+        node->ext->ir = NULL;
+        lai_put_ext(node);
     }
 
-    // Remove the node from its parent's hash table.
-    lai_nsnode_t *parent = node->parent;
-    if (parent) {
-        int h = lai_hash_string(node->name, 4);
-        struct lai_hashtable_chain chain = LAI_HASHTABLE_CHAIN_INITIALIZER;
-        for (;;) {
-            if (lai_hashtable_chain_advance(&parent->children, h, &chain))
-                lai_panic("child node is missing from parent's hash table"
-                          " during lai_uninstall_nsnode()");
-            lai_nsnode_t *child = lai_hashtable_chain_get(&parent->children, h, &chain);
-            if (child != node)
-                continue;
-            lai_hashtable_chain_remove(&parent->children, h, &chain);
-            break;
+    if (node->ns_index + 1 == instance->ns_size) {
+        instance->ns_size--;
+    } else {
+        if (instance->ns_num_free == instance->ns_free_capacity) {
+            size_t new_capacity = instance->ns_free_capacity * 2;
+            if (!new_capacity)
+                new_capacity = 32;
+            size_t *new_slots;
+            new_slots = laihost_realloc(instance->ns_free_slots, sizeof(size_t) * new_capacity,
+                                        sizeof(size_t) * instance->ns_free_capacity);
+            if (!new_slots)
+                lai_panic("could not reallocate namespace free list");
+            instance->ns_free_slots = new_slots;
+            instance->ns_free_capacity = new_capacity;
         }
+        instance->ns_free_slots[instance->ns_num_free++] = node->ns_index;
+    }
 
-        // As a sanity-check: make sure that the child does not occur twice.
-        while (!lai_hashtable_chain_advance(&parent->children, h, &chain)) {
-            lai_nsnode_t *child = lai_hashtable_chain_get(&parent->children, h, &chain);
-            if (child == node)
-                lai_panic("child node appears multiple times in parent's hash table"
-                          " during lai_uninstall_nsnode()");
-        }
+    instance->ns_generation++;
+    if (lai_ns_affects_device_index(node))
+        instance->device_generation++;
+
+    // Remove the node from its parent's hash table and list of children.
+    lai_nsnode_t *parent = node->parent;
+    if (parent) {
+        struct lai_nsnode_ext *ext = parent->ext;
+        uint32_t key = lai_ns_name_key(node->name);
+        lai_nsnode_t *child = NULL;
+        if (ext)
+            child = lai_hashtable_remove(&ext->children, key);
+        if (!child)
+            lai_panic("child node is missing from parent's hash table"
+                      " during lai_uninstall_nsnode()");
+        if (child != node)
+            lai_panic("parent's hash table contains a different node with the same name"
+                      " during lai_uninstall_nsnode()");
+
+        if (node->prev_sibling)
+            node->prev_sibling->next_sibling = node->next_sibling;
+        else
+            ext->first_child = node->next_sibling;
+        if (node->next_sibling)
+            node->next_sibling->prev_sibling = node->prev_sibling;
+        else
+            ext->last_child = node->prev_sibling;
+        node->next_sibling = NULL;
+        node->prev_sibling = NULL;
+
+        lai_put_ext(parent);
     }
 }
 
@@ -137,14 +257,9 @@ lai_nsnode_t *lai_ns_get_parent(lai_nsnode_t *node) {
 }
 
 lai_nsnode_t *lai_ns_get_child(lai_nsnode_t *parent, const char *name) {
-    int h = lai_hash_string(name, 4);
-    struct lai_hashtable_chain chain = LAI_HASHTABLE_CHAIN_INITIALIZER;
-    while (!lai_hashtable_chain_advance(&parent->children, h, &chain)) {
-        lai_nsnode_t *child = lai_hashtable_chain_get(&parent->children, h, &chain);
-        if (!memcmp(child->name, name, 4))
-            return child;
-    }
-    return NULL;
+    if (!parent->ext)
+        return NULL;
+    return lai_hashtable_find(&parent->ext->children, lai_ns_name_key(name));
 }
 
 size_t lai_amlname_parse(struct lai_amlname *amln, const void *data) {
@@ -345,6 +460,82 @@ lai_nsnode_t *lai_do_resolve(lai_nsnode_t *ctx_handle, const struct lai_amlname
     }
 }
 
+static int lai_name_cache_grow(struct lai_aml_segment *amls) {
+    size_t n = amls->name_cache_capacity ? 2 * amls->name_cache_capacity : 64;
+    size_t size = n * sizeof(struct lai_name_cache_entry);
+    struct lai_name_cache_entry *new_cache = laihost_malloc(size);
+    if (!new_cache)
+        return 1;
+    memset(new_cache, 0, size);
+
+    for (size_t k = 0; k < amls->name_cache_capacity; k++) {
+        struct lai_name_cache_entry *entry = &amls->name_cache[k];
+        if (!entry->aml)
+            continue;
+        for (uint32_t i = lai_hashtable_hash((uint32_t)(uintptr_t)entry->aml);; i++) {
+            struct lai_name_cache_entry *new_entry = &new_cache[i & (n - 1)];
+            if (!new_entry->aml) {
+                *new_entry = *entry;
+                break;
+            }
+        }
+    }
+
+    if (amls->name_cache_capacity)
+        laihost_free(amls->name_cache,
+                     amls->name_cache_capacity * sizeof(struct lai_name_cache_entry));
+    amls->name_cache = new_cache;
+    amls->name_cache_capacity = n;
+    return 0;
+}
+
+// Like lai_do_resolve() but caches the result. Methods resolve the same names each time
+// that they run; this avoids walking the namespace (and, for unqualified names, all parent
+// scopes) again. aml is the address of the NameString within the table of amls.
+// Entries are invalidated whenever a node is installed or uninstalled.
+lai_nsnode_t *lai_do_resolve_cached(struct lai_aml_segment *amls, lai_nsnode_t *ctx_handle,
+                                    const uint8_t *aml, const struct lai_amlname *amln) {
+    uint64_t generation = lai_current_instance()->ns_generation;
+    uint32_t hash = lai_hashtable_hash((uint32_t)(uintptr_t)aml);
+
+    struct lai_name_cache_entry *entry = NULL;
+    if (amls->name_cache_capacity) {
+        for (uint32_t i = hash;; i++) {
+            entry = &amls->name_cache[i & (amls->name_cache_capacity - 1)];
+            if (entry->aml == aml) {
+                if (entry->generation == generation && entry->ctx_handle == ctx_handle)
+                    return entry->node;
+                break; // Stale entry, refresh it below.
+            }
+            if (!entry->aml) {
+                entry = NULL;
+                break;
+            }
+        }
+    }
+
+    lai_nsnode_t *node = lai_do_resolve(ctx_handle, amln);
+
+    if (!entry) {
+        // Keep the load factor below 3/4. If we cannot grow the table, do not cache.
+        if (4 * (amls->name_cache_size + 1) > 3 * amls->name_cache_capacity
+            && lai_name_cache_grow(amls))
+            return node;
+
+        for (uint32_t i = hash;; i++) {
+            entry = &amls->name_cache[i & (amls->name_cache_capacity - 1)];
+            if (!entry->aml)
+                break;
+        }
+        entry->aml = aml;
+        amls->name_cache_size++;
+    }
+    entry->ctx_handle = ctx_handle;
+    entry->node = node;
+    entry->generation = generation;
+    return node;
+}
+
 void lai_do_resolve_new_node(lai_nsnode_t *node, lai_nsnode_t *ctx_handle,
                              const struct lai_amlname *in_amln) {
     // Make a copy to avoid rendering the original object unusable.
@@ -450,7 +641,7 @@ lai_nsnode_t *lai_create_root(void) {
     lai_namecpy(osi_node->name, "_OSI");
     osi_node->parent = instance->root_node;
     osi_node->method_flags = 0x01;
-    osi_node->method_override = &lai_do_osi_method;
+    lai_get_overrides(osi_node)->method_override = &lai_do_osi_method;
     lai_install_nsnode(osi_node);
 
     lai_nsnode_t *os_node = lai_create_nsnode_or_die();
@@ -458,7 +649,7 @@ lai_nsnode_t *lai_create_root(void) {
     lai_namecpy(os_node->name, "_OS_");
     os_node->parent = instance->root_node;
     os_node->method_flags = 0x00;
-    os_node->method_override = &lai_do_os_method;
+    lai_get_overrides(os_node)->method_override = &lai_do_os_method;
     lai_install_nsnode(os_node);
 
     lai_nsnode_t *rev_node = lai_create_nsnode_or_die();
@@ -466,7 +657,7 @@ lai_nsnode_t *lai_create_root(void) {
     lai_namecpy(rev_node->name, "_REV");
     rev_node->parent = instance->root_node;
     rev_node->method_flags = 0x00;
-    rev_node->method_override = &lai_do_rev_method;
+    lai_get_overrides(rev_node)->method_override = &lai_do_rev_method;
     lai_install_nsnode(rev_node);
 
     return instance->root_node;
@@ -524,10 +715,14 @@ void lai_create_namespace(void) {
         index++;
     }
 
+    // Drop the holes left behind by temporary nodes of the table code; before the namespace
+    // is handed to the host, nobody can be iterating over it.
+    lai_compact_ns_array();
+
     lai_debug("ACPI namespace created, total of %d predefined objects.", instance->ns_size);
 }
 
-static struct lai_aml_segment *lai_load_table(void *ptr, int index) {
+struct lai_aml_segment *lai_load_table(void *ptr, int index) {
     struct lai_aml_segment *amls = laihost_malloc(sizeof(struct lai_aml_segment));
     if (!amls)
         lai_panic("could not allocate memory for struct lai_aml_segment");
@@ -543,10 +738,8 @@ static struct lai_aml_segment *lai_load_table(void *ptr, int index) {
     return amls;
 }
 
-lai_nsnode_t *lai_resolve_path(lai_nsnode_t *ctx_handle, const char *path) {
+static lai_nsnode_t *lai_resolve_path_uncached(lai_nsnode_t *ctx_handle, const char *path) {
     lai_nsnode_t *current = ctx_handle;
-    if (!current)
-        current = lai_current_instance()->root_node;
 
     if (*path == '\\') {
         while (current->parent)
@@ -604,6 +797,70 @@ lai_nsnode_t *lai_resolve_path(lai_nsnode_t *ctx_handle, const char *path) {
     return current;
 }
 
+// Returns true if the path is a single NameSeg relative to the context node.
+static inline int lai_is_single_nameseg(const char *path) {
+    if (*path == '\\' || *path == '^')
+        return 0;
+    for (int k = 0; k < 5; k++) {
+        if (!path[k])
+            return 1;
+        if (path[k] == '.')
+            return 0;
+    }
+    return 0;
+}
+
+// Helpers resolve the same paths (e.g., \_SB_ or _SB_.PCI0) over and over again.
+// Hence, results are cached in a direct-mapped table that is keyed by (ctx_handle, path).
+// Instead of tracking which entries are affected by namespace changes, each entry records
+// ns_generation; installing or uninstalling any node invalidates all entries.
+lai_nsnode_t *lai_resolve_path(lai_nsnode_t *ctx_handle, const char *path) {
+    struct lai_instance *instance = lai_current_instance();
+    // Absolute paths do not depend on the context; share their cache entries.
+    if (!ctx_handle || *path == '\\')
+        ctx_handle = instance->root_node;
+
+    // Single NameSegs are resolved by a single hash table probe anyway.
+    if (lai_is_single_nameseg(path))
+        return lai_resolve_path_uncached(ctx_handle, path);
+
+    if (!instance->resolve_cache) {
+        size_t size = LAI_RESOLVE_CACHE_SIZE * sizeof(struct lai_resolve_cache_entry);
+        instance->resolve_cache = laihost_malloc(size);
+        if (!instance->resolve_cache)
+            return lai_resolve_path_uncached(ctx_handle, path);
+        memset(instance->resolve_cache, 0, size);
+    }
+
+    // Callers almost always pass string literals. Hash the address of the path to avoid
+    // hashing its contents; the contents are compared below, such that the result is
+    // correct even if the caller reuses its buffer for a different path.
+    // Nodes are 64-byte aligned, the low bits of the pointer carry no information.
+    uint32_t hash = lai_hashtable_hash((uint32_t)((uintptr_t)ctx_handle >> 6)
+                                       ^ (uint32_t)(uintptr_t)path);
+    struct lai_resolve_cache_entry *entry
+        = &instance->resolve_cache[hash & (LAI_RESOLVE_CACHE_SIZE - 1)];
+
+    // Generation zero is never cached, such that zeroed entries are invalid.
+    if (entry->generation == instance->ns_generation && entry->ctx_handle == ctx_handle) {
+        // entry->path is NUL-terminated, hence this loop always terminates.
+        for (size_t k = 0; entry->path[k] == path[k]; k++) {
+            if (!path[k])
+                return entry->result;
+        }
+    }
+
+    lai_nsnode_t *result = lai_resolve_path_uncached(ctx_handle, path);
+    size_t length = lai_strlen(path);
+    if (instance->ns_generation && length < LAI_RESOLVE_CACHE_MAX_PATH) {
+        entry->generation = instance->ns_generation;
+        entry->ctx_handle = ctx_handle;
+        entry->result = result;
+        memcpy(entry->path, path, length + 1);
+    }
+    return result;
+}
+
 lai_nsnode_t *lai_resolve_search(lai_nsnode_t *ctx_handle, const char *segment) {
     lai_nsnode_t *current = ctx_handle;
     LAI_ENSURE(current);
@@ -685,13 +942,30 @@ lai_nsnode_t *lai_ns_iterate(struct lai_ns_iterator *iter) {
     return NULL;
 }
 
+// Returns the children in definition order. The node that was returned last may be
+// uninstalled during the iteration.
 lai_nsnode_t *lai_ns_child_iterate(struct lai_ns_child_iterator *iter) {
-    while (iter->i < (size_t)iter->parent->children.elem_capacity) {
-        lai_nsnode_t *n = iter->parent->children.elem_ptr_tab[iter->i++];
-        if (n)
-            return n;
+    if (!iter->i) {
+        iter->i = 1;
+        iter->next = iter->parent->ext ? iter->parent->ext->first_child : NULL;
     }
 
+    lai_nsnode_t *n = iter->next;
+    if (n)
+        iter->next = n->next_sibling;
+    return n;
+}
+
+// Pre-order traversal of the subtree below root, following the lists of children.
+// Root itself is not returned.
+lai_nsnode_t *lai_ns_preorder_next(lai_nsnode_t *root, lai_nsnode_t *node) {
+    if (node->ext && node->ext->first_child)
+        return node->ext->first_child;
+    while (node != root) {
+        if (node->next_sibling)
+            return node->next_sibling;
+        node = node->parent;
+    }
     return NULL;
 }
 
@@ -700,8 +974,9 @@ lai_api_error_t lai_ns_override_notify(lai_nsnode_t *node,
                                        void *userptr) {
     LAI_ENSURE(node);
 
-    node->notify_override = override;
-    node->notify_userptr = userptr;
+    struct lai_nsnode_overrides *overrides = lai_get_overrides(node);
+    overrides->notify_override = override;
+    overrides->notify_userptr = userptr;
     return LAI_ERROR_NONE;
 }
 
@@ -711,8 +986,9 @@ lai_api_error_t lai_ns_override_opregion(lai_nsnode_t *node,
     LAI_ENSURE(node);
     LAI_ENSURE(node->type == LAI_NAMESPACE_OPREGION);
 
-    node->op_override = override;
-    node->op_userptr = userptr;
+    struct lai_nsnode_overrides *overrides = lai_get_overrides(node);
+    overrides->op_override = override;
+    overrides->op_userptr = userptr;
     return LAI_ERROR_NONE;
 }
 
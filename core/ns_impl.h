@@ -14,6 +14,14 @@ lai_nsnode_t *lai_create_nsnode(void);
 lai_nsnode_t *lai_create_nsnode_or_die(void);
 void lai_install_nsnode(lai_nsnode_t *node);
 void lai_uninstall_nsnode(lai_nsnode_t *node);
+struct lai_nsnode_overrides *lai_get_overrides(lai_nsnode_t *node);
+// Returns the decoded instructions of a method (allocating them on first use) or NULL.
+struct lai_method_ir *lai_get_method_ir(lai_nsnode_t *node);
+// Pre-order traversal of the subtree below root (in definition order).
+lai_nsnode_t *lai_ns_preorder_next(lai_nsnode_t *root, lai_nsnode_t *node);
+
+// Creates the struct lai_aml_segment for an AML table.
+struct lai_aml_segment *lai_load_table(void *ptr, int index);
 
 // Sets the name and parent of a namespace node.
 size_t lai_resolve_new_node(lai_nsnode_t *node, lai_nsnode_t *ctx_handle, void *data);
@@ -8,23 +8,44 @@
 #include "aml_opcodes.h"
 #include "exec_impl.h"
 #include "libc.h"
+#include "slab.h"
 
-lai_api_error_t lai_create_string(lai_variable_t *object, size_t length) {
+lai_api_error_t lai_exec_create_string(lai_state_t *state, lai_variable_t *object,
+                                       size_t length) {
     object->type = LAI_STRING;
-    object->string_ptr = laihost_malloc(sizeof(struct lai_string_head));
+    object->string_ptr = lai_slab_alloc(LAI_SLAB_STRING_HEAD);
     if (!object->string_ptr)
         return LAI_ERROR_OUT_OF_MEMORY;
     object->string_ptr->rc = 1;
-    object->string_ptr->content = laihost_malloc(length + 1);
-    object->string_ptr->capacity = length + 1;
-    if (!object->string_ptr->content) {
-        laihost_free(object->string_ptr, sizeof(struct lai_string_head));
-        return LAI_ERROR_OUT_OF_MEMORY;
+    object->string_ptr->in_arena = 0;
+    object->string_ptr->shared = NULL;
+    if (length + 1 <= LAI_SMALL_STRING_CAPACITY) {
+        object->string_ptr->content = object->string_ptr->inline_content;
+        object->string_ptr->capacity = LAI_SMALL_STRING_CAPACITY;
+    } else {
+        object->string_ptr->capacity = length + 1;
+        if (state)
+            object->string_ptr->content = lai_exec_arena_alloc(state, length + 1);
+        else
+            object->string_ptr->content = NULL;
+        if (object->string_ptr->content) {
+            object->string_ptr->in_arena = 1;
+        } else {
+            object->string_ptr->content = laihost_malloc(length + 1);
+            if (!object->string_ptr->content) {
+                lai_slab_free(LAI_SLAB_STRING_HEAD, object->string_ptr);
+                return LAI_ERROR_OUT_OF_MEMORY;
+            }
+        }
     }
     memset(object->string_ptr->content, 0, length + 1);
     return LAI_ERROR_NONE;
 }
 
+lai_api_error_t lai_create_string(lai_variable_t *object, size_t length) {
+    return lai_exec_create_string(NULL, object, length);
+}
+
 lai_api_error_t lai_create_c_string(lai_variable_t *object, const char *s) {
     size_t n = lai_strlen(s);
     lai_api_error_t e = lai_create_string(object, n);
@@ -34,49 +55,112 @@ lai_api_error_t lai_create_c_string(lai_variable_t *object, const char *s) {
     return LAI_ERROR_NONE;
 }
 
-lai_api_error_t lai_create_buffer(lai_variable_t *object, size_t size) {
+lai_api_error_t lai_exec_create_buffer(lai_state_t *state, lai_variable_t *object, size_t size) {
     object->type = LAI_BUFFER;
-    object->buffer_ptr = laihost_malloc(sizeof(struct lai_buffer_head));
+    object->buffer_ptr = lai_slab_alloc(LAI_SLAB_BUFFER_HEAD);
     if (!object->buffer_ptr)
         return LAI_ERROR_OUT_OF_MEMORY;
     object->buffer_ptr->rc = 1;
+    object->buffer_ptr->in_arena = 0;
+    object->buffer_ptr->shared = NULL;
     object->buffer_ptr->size = size;
-    object->buffer_ptr->content = laihost_malloc(size);
-    if (!object->buffer_ptr->content) {
-        laihost_free(object->buffer_ptr, sizeof(struct lai_buffer_head));
-        return LAI_ERROR_OUT_OF_MEMORY;
+    if (size <= LAI_SMALL_BUFFER_SIZE) {
+        object->buffer_ptr->content = object->buffer_ptr->inline_content;
+    } else {
+        if (state)
+            object->buffer_ptr->content = lai_exec_arena_alloc(state, size);
+        else
+            object->buffer_ptr->content = NULL;
+        if (object->buffer_ptr->content) {
+            object->buffer_ptr->in_arena = 1;
+        } else {
+            object->buffer_ptr->content = laihost_malloc(size);
+            if (!object->buffer_ptr->content) {
+                lai_slab_free(LAI_SLAB_BUFFER_HEAD, object->buffer_ptr);
+                return LAI_ERROR_OUT_OF_MEMORY;
+            }
+        }
     }
     memset(object->buffer_ptr->content, 0, size);
     return LAI_ERROR_NONE;
 }
 
-lai_api_error_t lai_create_pkg(lai_variable_t *object, size_t n) {
+lai_api_error_t lai_create_buffer(lai_variable_t *object, size_t size) {
+    return lai_exec_create_buffer(NULL, object, size);
+}
+
+struct lai_pkg_block *lai_exec_alloc_pkg_block(size_t num_pkgs, size_t num_elems) {
+    size_t size = sizeof(struct lai_pkg_block) + num_pkgs * sizeof(struct lai_pkg_head)
+                  + num_elems * sizeof(lai_variable_t);
+    struct lai_pkg_block *block = laihost_malloc(size);
+    if (!block)
+        return NULL;
+    block->rc = 0;
+    block->size = size;
+    block->used = sizeof(struct lai_pkg_block);
+    return block;
+}
+
+int lai_exec_create_pkg_in_block(lai_variable_t *object, struct lai_pkg_block *block, size_t n) {
+    size_t size = sizeof(struct lai_pkg_head) + n * sizeof(lai_variable_t);
+    if (size > block->size - block->used)
+        return 1;
+    struct lai_pkg_head *head = (struct lai_pkg_head *)((uint8_t *)block + block->used);
+    block->used += size;
+
+    // One reference for the head and one for the elements.
+    block->rc += 2;
+    head->rc = 1;
+    head->size = n;
+    head->elems = (lai_variable_t *)(head + 1);
+    head->shared = NULL;
+    head->block = block;
+    head->elems_block = block;
+    head->capacity = n;
+    memset(head->elems, 0, n * sizeof(lai_variable_t));
     object->type = LAI_PACKAGE;
-    object->pkg_ptr = laihost_malloc(sizeof(struct lai_pkg_head));
-    if (!object->pkg_ptr)
+    object->pkg_ptr = head;
+    return 0;
+}
+
+lai_api_error_t lai_create_pkg(lai_variable_t *object, size_t n) {
+    struct lai_pkg_block *block = lai_exec_alloc_pkg_block(1, n);
+    if (!block)
         return LAI_ERROR_OUT_OF_MEMORY;
-    object->pkg_ptr->rc = 1;
-    object->pkg_ptr->size = n;
-    object->pkg_ptr->elems = laihost_malloc(n * sizeof(lai_variable_t));
-    if (!object->pkg_ptr->elems) {
-        laihost_free(object->pkg_ptr, sizeof(struct lai_pkg_head));
+    LAI_ENSURE(!lai_exec_create_pkg_in_block(object, block, n));
+    return LAI_ERROR_NONE;
+}
+
+lai_api_error_t lai_exec_create_lazy_handle(lai_variable_t *object, lai_nsnode_t *ctx_handle,
+                                            const uint8_t *aml) {
+    struct lai_lazy_handle *head = lai_slab_alloc(LAI_SLAB_LAZY_HANDLE);
+    if (!head)
         return LAI_ERROR_OUT_OF_MEMORY;
-    }
-    memset(object->pkg_ptr->elems, 0, n * sizeof(lai_variable_t));
+    head->rc = 1;
+    head->ctx_handle = ctx_handle;
+    head->aml = aml;
+    object->type = LAI_LAZY_HANDLE;
+    object->lazy_ptr = head;
     return LAI_ERROR_NONE;
 }
 
 lai_api_error_t lai_obj_resize_string(lai_variable_t *object, size_t length) {
     if (object->type != LAI_STRING)
         return LAI_ERROR_TYPE_MISMATCH;
-    if (length > lai_strlen(object->string_ptr->content)) {
+    struct lai_string_head *head = object->string_ptr;
+    lai_exec_unshare_string(head);
+    if (length + 1 > head->capacity) {
         char *new_content = laihost_malloc(length + 1);
         if (!new_content)
             return LAI_ERROR_OUT_OF_MEMORY;
-        lai_strcpy(new_content, object->string_ptr->content);
-        laihost_free(object->string_ptr->content, object->string_ptr->capacity);
-        object->string_ptr->content = new_content;
-        object->string_ptr->capacity = length + 1;
+        lai_strcpy(new_content, head->content);
+        if (head->in_arena)
+            lai_exec_arena_free(head->content);
+        else if (head->content != head->inline_content)
+            laihost_free(head->content, head->capacity);
+        head->content = new_content;
+        head->capacity = length + 1;
+        head->in_arena = 0;
     }
     return LAI_ERROR_NONE;
 }
@@ -84,36 +168,51 @@ lai_api_error_t lai_obj_resize_string(lai_variable_t *object, size_t length) {
 lai_api_error_t lai_obj_resize_buffer(lai_variable_t *object, size_t size) {
     if (object->type != LAI_BUFFER)
         return LAI_ERROR_TYPE_MISMATCH;
-    if (size > object->buffer_ptr->size) {
-        uint8_t *new_content = laihost_malloc(size);
-        if (!new_content)
-            return LAI_ERROR_OUT_OF_MEMORY;
-        memset(new_content, 0, size);
-        memcpy(new_content, object->buffer_ptr->content, object->buffer_ptr->size);
-        laihost_free(object->buffer_ptr->content, object->buffer_ptr->size);
-        object->buffer_ptr->content = new_content;
+    struct lai_buffer_head *head = object->buffer_ptr;
+    lai_exec_unshare_buffer(head);
+    if (size > head->size) {
+        if (head->content == head->inline_content && size <= LAI_SMALL_BUFFER_SIZE) {
+            memset(head->content + head->size, 0, size - head->size);
+        } else {
+            uint8_t *new_content = laihost_malloc(size);
+            if (!new_content)
+                return LAI_ERROR_OUT_OF_MEMORY;
+            memset(new_content, 0, size);
+            memcpy(new_content, head->content, head->size);
+            if (head->in_arena)
+                lai_exec_arena_free(head->content);
+            else if (head->content != head->inline_content)
+                laihost_free(head->content, head->size);
+            head->content = new_content;
+            head->in_arena = 0;
+        }
     }
-    object->buffer_ptr->size = size;
+    head->size = size;
     return LAI_ERROR_NONE;
 }
 
 lai_api_error_t lai_obj_resize_pkg(lai_variable_t *object, size_t n) {
     if (object->type != LAI_PACKAGE)
         return LAI_ERROR_TYPE_MISMATCH;
-    if (n <= object->pkg_ptr->size) {
-        for (unsigned int i = n; i < object->pkg_ptr->size; i++)
-            lai_var_finalize(&object->pkg_ptr->elems[i]);
-    } else {
+    struct lai_pkg_head *head = object->pkg_ptr;
+    lai_exec_unshare_pkg(head);
+    if (n <= head->size) {
+        for (unsigned int i = n; i < head->size; i++)
+            lai_var_finalize(&head->elems[i]);
+    } else if (n > head->capacity) {
+        // Elements beyond the size are always zero; hence, growing within the capacity
+        // does not need to touch them.
         struct lai_variable_t *new_elems = laihost_malloc(n * sizeof(lai_variable_t));
         if (!new_elems)
             return LAI_ERROR_OUT_OF_MEMORY;
         memset(new_elems, 0, n * sizeof(lai_variable_t));
-        for (unsigned int i = 0; i < object->pkg_ptr->size; i++)
-            lai_var_move(&new_elems[i], &object->pkg_ptr->elems[i]);
-        laihost_free(object->pkg_ptr->elems, object->pkg_ptr->size * sizeof(lai_variable_t));
-        object->pkg_ptr->elems = new_elems;
+        for (unsigned int i = 0; i < head->size; i++)
+            lai_var_move(&new_elems[i], &head->elems[i]);
+        lai_exec_release_pkg_elems(head);
+        head->elems = new_elems;
+        head->capacity = n;
     }
-    object->pkg_ptr->size = n;
+    head->size = n;
     return LAI_ERROR_NONE;
 }
 
@@ -155,9 +254,9 @@ enum lai_object_type lai_obj_get_type(lai_variable_t *object) {
             return lai_object_type_of_node(object->handle);
         case LAI_LAZY_HANDLE: {
             struct lai_amlname amln;
-            lai_amlname_parse(&amln, object->unres_aml);
+            lai_amlname_parse(&amln, object->lazy_ptr->aml);
 
-            lai_nsnode_t *handle = lai_do_resolve(object->unres_ctx_handle, &amln);
+            lai_nsnode_t *handle = lai_do_resolve(object->lazy_ptr->ctx_handle, &amln);
             if (!handle)
                 lai_panic("undefined reference %s", lai_stringify_amlname(&amln));
             return lai_object_type_of_node(handle);
@@ -187,7 +286,20 @@ lai_api_error_t lai_obj_get_pkg(lai_variable_t *object, size_t i, lai_variable_t
         return LAI_ERROR_TYPE_MISMATCH;
     if (i >= lai_exec_pkg_size(object))
         return LAI_ERROR_OUT_OF_BOUNDS;
-    lai_exec_pkg_load(out, object, i);
+    // Unlike lai_exec_pkg_load(), this does not unshare the package.
+    if (!object->pkg_ptr->shared) {
+        lai_var_assign(out, &object->pkg_ptr->elems[i]);
+        return 0;
+    }
+
+    // The elements are shared with other clones (e.g., with the object of a Name()).
+    // The caller can write to strings and buffers through lai_exec_*_access(), bypassing
+    // copy-on-write; hence, it gets private copies of them.
+    lai_obj_clone(out, &object->pkg_ptr->elems[i]);
+    if (out->type == LAI_STRING)
+        lai_exec_unshare_string(out->string_ptr);
+    else if (out->type == LAI_BUFFER)
+        lai_exec_unshare_buffer(out->buffer_ptr);
     return 0;
 }
 
@@ -198,9 +310,9 @@ lai_api_error_t lai_obj_get_handle(lai_variable_t *object, lai_nsnode_t **out) {
             return LAI_ERROR_NONE;
         case LAI_LAZY_HANDLE: {
             struct lai_amlname amln;
-            lai_amlname_parse(&amln, object->unres_aml);
+            lai_amlname_parse(&amln, object->lazy_ptr->aml);
 
-            lai_nsnode_t *handle = lai_do_resolve(object->unres_ctx_handle, &amln);
+            lai_nsnode_t *handle = lai_do_resolve(object->lazy_ptr->ctx_handle, &amln);
             if (!handle)
                 lai_panic("undefined reference %s", lai_stringify_amlname(&amln));
             *out = handle;
@@ -214,10 +326,70 @@ lai_api_error_t lai_obj_get_handle(lai_variable_t *object, lai_nsnode_t **out) {
     }
 }
 
-lai_api_error_t lai_obj_to_buffer(lai_variable_t *out, lai_variable_t *object) {
+lai_api_error_t lai_obj_view_pkg(lai_variable_t *object, struct lai_pkg_view *view) {
+    if (object->type != LAI_PACKAGE)
+        return LAI_ERROR_TYPE_MISMATCH;
+    // Like lai_obj_get_pkg(), this reads the elements without unsharing the package.
+    view->elems = object->pkg_ptr->elems;
+    view->size = object->pkg_ptr->size;
+    return LAI_ERROR_NONE;
+}
+
+lai_api_error_t lai_obj_view_buffer(lai_variable_t *object, struct lai_buffer_view *view) {
+    if (object->type != LAI_BUFFER)
+        return LAI_ERROR_TYPE_MISMATCH;
+    view->data = object->buffer_ptr->content;
+    view->size = object->buffer_ptr->size;
+    return LAI_ERROR_NONE;
+}
+
+enum lai_object_type lai_pkg_view_get_type(struct lai_pkg_view *view, size_t i) {
+    if (i >= view->size)
+        return LAI_TYPE_NONE;
+    return lai_obj_get_type(&view->elems[i]);
+}
+
+lai_api_error_t lai_pkg_view_get_integer(struct lai_pkg_view *view, size_t i, uint64_t *out) {
+    if (i >= view->size)
+        return LAI_ERROR_OUT_OF_BOUNDS;
+    return lai_obj_get_integer(&view->elems[i], out);
+}
+
+lai_api_error_t lai_pkg_view_get_string(struct lai_pkg_view *view, size_t i, const char **out) {
+    if (i >= view->size)
+        return LAI_ERROR_OUT_OF_BOUNDS;
+    if (view->elems[i].type != LAI_STRING)
+        return LAI_ERROR_TYPE_MISMATCH;
+    *out = view->elems[i].string_ptr->content;
+    return LAI_ERROR_NONE;
+}
+
+lai_api_error_t lai_pkg_view_get_buffer(struct lai_pkg_view *view, size_t i,
+                                        struct lai_buffer_view *out) {
+    if (i >= view->size)
+        return LAI_ERROR_OUT_OF_BOUNDS;
+    return lai_obj_view_buffer(&view->elems[i], out);
+}
+
+lai_api_error_t lai_pkg_view_get_pkg(struct lai_pkg_view *view, size_t i,
+                                     struct lai_pkg_view *out) {
+    if (i >= view->size)
+        return LAI_ERROR_OUT_OF_BOUNDS;
+    return lai_obj_view_pkg(&view->elems[i], out);
+}
+
+lai_api_error_t lai_pkg_view_get_handle(struct lai_pkg_view *view, size_t i,
+                                        lai_nsnode_t **out) {
+    if (i >= view->size)
+        return LAI_ERROR_OUT_OF_BOUNDS;
+    return lai_obj_get_handle(&view->elems[i], out);
+}
+
+lai_api_error_t lai_exec_obj_to_buffer(lai_state_t *state, lai_variable_t *out,
+                                       lai_variable_t *object) {
     switch (object->type) {
         case LAI_TYPE_INTEGER:
-            if (lai_create_buffer(out, sizeof(uint64_t)) != LAI_ERROR_NONE)
+            if (lai_exec_create_buffer(state, out, sizeof(uint64_t)) != LAI_ERROR_NONE)
                 return LAI_ERROR_OUT_OF_MEMORY;
             memcpy(out->buffer_ptr->content, &object->integer, sizeof(uint64_t));
             break;
@@ -229,10 +401,10 @@ lai_api_error_t lai_obj_to_buffer(lai_variable_t *out, lai_variable_t *object) {
         case LAI_TYPE_STRING: {
             size_t len = lai_exec_string_length(object);
             if (len == 0) {
-                if (lai_create_buffer(out, 0) != LAI_ERROR_NONE)
+                if (lai_exec_create_buffer(state, out, 0) != LAI_ERROR_NONE)
                     return LAI_ERROR_OUT_OF_MEMORY;
             } else {
-                if (lai_create_buffer(out, len + 1) != LAI_ERROR_NONE)
+                if (lai_exec_create_buffer(state, out, len + 1) != LAI_ERROR_NONE)
                     return LAI_ERROR_OUT_OF_MEMORY;
                 memcpy(out->buffer_ptr->content, object->string_ptr->content, len);
             }
@@ -247,9 +419,15 @@ lai_api_error_t lai_obj_to_buffer(lai_variable_t *out, lai_variable_t *object) {
     return LAI_ERROR_NONE;
 }
 
+lai_api_error_t lai_obj_to_buffer(lai_variable_t *out, lai_variable_t *object) {
+    return lai_exec_obj_to_buffer(NULL, out, object);
+}
+
 lai_api_error_t lai_mutate_buffer(lai_variable_t *target, lai_variable_t *object) {
     // Buffers are *not* resized during mutation.
     // The target buffer determines the size of the result.
+    LAI_ENSURE(target->type == LAI_BUFFER);
+    lai_exec_unshare_buffer(target->buffer_ptr);
 
     switch (object->type) {
         // No conversion necessary.
@@ -293,7 +471,8 @@ lai_api_error_t lai_mutate_buffer(lai_variable_t *target, lai_variable_t *object
     return LAI_ERROR_NONE;
 }
 
-lai_api_error_t lai_obj_to_string(lai_variable_t *out, lai_variable_t *object, size_t size) {
+lai_api_error_t lai_exec_obj_to_string(lai_state_t *state, lai_variable_t *out,
+                                       lai_variable_t *object, size_t size) {
     switch (object->type) {
         case LAI_TYPE_BUFFER: {
             size_t buffer_length = 0;
@@ -305,19 +484,19 @@ lai_api_error_t lai_obj_to_string(lai_variable_t *out, lai_variable_t *object, s
             }
 
             if (buffer_length == 0) {
-                lai_create_string(out, 0);
+                lai_exec_create_string(state, out, 0);
             } else if (size == ~(size_t)(0)) {
                 // Copy until the '\0'
-                lai_create_string(out, buffer_length + 1);
+                lai_exec_create_string(state, out, buffer_length + 1);
                 char *string = lai_exec_string_access(out);
                 memcpy(string, buffer, buffer_length);
             } else {
                 if (size < buffer_length) {
-                    lai_create_string(out, size);
+                    lai_exec_create_string(state, out, size);
                     char *string = lai_exec_string_access(out);
                     memcpy(string, buffer, size);
                 } else {
-                    lai_create_string(out, buffer_length);
+                    lai_exec_create_string(state, out, buffer_length);
                     char *string = lai_exec_string_access(out);
                     memcpy(string, buffer, buffer_length);
                 }
@@ -333,10 +512,15 @@ lai_api_error_t lai_obj_to_string(lai_variable_t *out, lai_variable_t *object, s
     return LAI_ERROR_NONE;
 }
 
-lai_api_error_t lai_obj_to_decimal_string(lai_variable_t *out, lai_variable_t *object) {
+lai_api_error_t lai_obj_to_string(lai_variable_t *out, lai_variable_t *object, size_t size) {
+    return lai_exec_obj_to_string(NULL, out, object, size);
+}
+
+lai_api_error_t lai_exec_obj_to_decimal_string(lai_state_t *state, lai_variable_t *out,
+                                               lai_variable_t *object) {
     switch (object->type) {
         case LAI_INTEGER: {
-            lai_create_string(out, 20); // Max length for 64-bit integer is 20 chars
+            lai_exec_create_string(state, out, 20); // Max length for 64-bit integer is 20 chars
             char *s = lai_exec_string_access(out);
             lai_snprintf(s, 21, "%llu", object->integer); // snprintf null terminates
             break;
@@ -345,9 +529,8 @@ lai_api_error_t lai_obj_to_decimal_string(lai_variable_t *out, lai_variable_t *o
         case LAI_BUFFER: {
             size_t buffer_len = lai_exec_buffer_size(object);
             uint8_t *buffer = lai_exec_buffer_access(object);
-            lai_create_string(
-                out,
-                (buffer_len * 3)); // For every buffer byte we need 2 chars of number and a comma
+            // For every buffer byte we need 2 chars of number and a comma
+            lai_exec_create_string(state, out, buffer_len * 3);
 
             char *string = lai_exec_string_access(out);
             uint64_t string_index = 0;
@@ -378,12 +561,17 @@ lai_api_error_t lai_obj_to_decimal_string(lai_variable_t *out, lai_variable_t *o
     return LAI_ERROR_NONE;
 }
 
+lai_api_error_t lai_obj_to_decimal_string(lai_variable_t *out, lai_variable_t *object) {
+    return lai_exec_obj_to_decimal_string(NULL, out, object);
+}
+
 // The spec doesn't mention this but the numbers should be prefixed with 0x
-lai_api_error_t lai_obj_to_hex_string(lai_variable_t *out, lai_variable_t *object) {
+lai_api_error_t lai_exec_obj_to_hex_string(lai_state_t *state, lai_variable_t *out,
+                                           lai_variable_t *object) {
     switch (object->type) {
         case LAI_INTEGER: {
-            lai_create_string(
-                out, 16); // 64-bit integer is 8 bytes, each byte takes 2 chars, is 16 chars
+            // 64-bit integer is 8 bytes, each byte takes 2 chars, is 16 chars
+            lai_exec_create_string(state, out, 16);
             char *s = lai_exec_string_access(out);
             lai_snprintf(s, 17, "%X", object->integer); // snprintf null terminates
             break;
@@ -392,11 +580,9 @@ lai_api_error_t lai_obj_to_hex_string(lai_variable_t *out, lai_variable_t *objec
         case LAI_BUFFER: {
             size_t buffer_len = lai_exec_buffer_size(object);
             uint8_t *buffer = lai_exec_buffer_access(object);
-            lai_create_string(
-                out,
-                (buffer_len
-                 * 5)); // For every buffer byte we need 2 chars of prefix, 2 chars of number and a
-                        // comma I'll take the 1 byte loss of the last comma for code simplicity
+            // For every buffer byte we need 2 chars of prefix, 2 chars of number and a comma
+            // I'll take the 1 byte loss of the last comma for code simplicity
+            lai_exec_create_string(state, out, buffer_len * 5);
 
             char *string = lai_exec_string_access(out);
             uint64_t string_index = 0;
@@ -429,6 +615,10 @@ lai_api_error_t lai_obj_to_hex_string(lai_variable_t *out, lai_variable_t *objec
     return LAI_ERROR_NONE;
 }
 
+lai_api_error_t lai_obj_to_hex_string(lai_variable_t *out, lai_variable_t *object) {
+    return lai_exec_obj_to_hex_string(NULL, out, object);
+}
+
 lai_api_error_t lai_mutate_string(lai_variable_t *target, lai_variable_t *object) {
     // Strings are resized during mutation.
 
@@ -679,29 +869,236 @@ lai_api_error_t lai_mutate_integer(lai_variable_t *target, lai_variable_t *objec
     return LAI_ERROR_NONE;
 }
 
-// lai_clone_buffer(): Clones a buffer object
+// lai_clone_buffer(): Clones a buffer object (without copying its content)
 static void lai_clone_buffer(lai_variable_t *dest, lai_variable_t *source) {
-    size_t size = lai_exec_buffer_size(source);
-    if (lai_create_buffer(dest, size) != LAI_ERROR_NONE)
+    struct lai_buffer_head *head = source->buffer_ptr;
+    if (!head->shared) {
+        // Move the content to a new head that is shared by head and all of its clones.
+        struct lai_buffer_head *storage = lai_slab_alloc(LAI_SLAB_BUFFER_HEAD);
+        if (!storage)
+            lai_panic("unable to allocate memory for buffer object.");
+        storage->rc = 1;
+        storage->size = head->size;
+        storage->content = head->content;
+        storage->shared = NULL;
+        storage->in_arena = head->in_arena;
+        if (head->content == head->inline_content) {
+            // Inline content must not outlive head; hence, copy it to the storage head.
+            memcpy(storage->inline_content, head->inline_content, head->size);
+            storage->content = storage->inline_content;
+            head->content = storage->content;
+        }
+        head->shared = storage;
+    }
+
+    struct lai_buffer_head *clone = lai_slab_alloc(LAI_SLAB_BUFFER_HEAD);
+    if (!clone)
         lai_panic("unable to allocate memory for buffer object.");
-    memcpy(lai_exec_buffer_access(dest), lai_exec_buffer_access(source), size);
+    clone->rc = 1;
+    clone->size = head->size;
+    clone->content = head->content;
+    clone->in_arena = 0;
+    clone->shared = head->shared;
+    lai_rc_ref(&head->shared->rc);
+    dest->type = LAI_BUFFER;
+    dest->buffer_ptr = clone;
 }
 
-// lai_clone_string(): Clones a string object
+// lai_clone_string(): Clones a string object (without copying its content)
 static void lai_clone_string(lai_variable_t *dest, lai_variable_t *source) {
-    size_t n = lai_exec_string_length(source);
-    if (lai_create_string(dest, n) != LAI_ERROR_NONE)
+    struct lai_string_head *head = source->string_ptr;
+    if (!head->shared) {
+        struct lai_string_head *storage = lai_slab_alloc(LAI_SLAB_STRING_HEAD);
+        if (!storage)
+            lai_panic("unable to allocate memory for string object.");
+        storage->rc = 1;
+        storage->capacity = head->capacity;
+        storage->content = head->content;
+        storage->shared = NULL;
+        storage->in_arena = head->in_arena;
+        if (head->content == head->inline_content) {
+            memcpy(storage->inline_content, head->inline_content, head->capacity);
+            storage->content = storage->inline_content;
+            head->content = storage->content;
+        }
+        head->shared = storage;
+    }
+
+    struct lai_string_head *clone = lai_slab_alloc(LAI_SLAB_STRING_HEAD);
+    if (!clone)
         lai_panic("unable to allocate memory for string object.");
-    memcpy(lai_exec_string_access(dest), lai_exec_string_access(source), n);
+    clone->rc = 1;
+    clone->capacity = head->capacity;
+    clone->content = head->content;
+    clone->in_arena = 0;
+    clone->shared = head->shared;
+    lai_rc_ref(&head->shared->rc);
+    dest->type = LAI_STRING;
+    dest->string_ptr = clone;
 }
 
-// lai_clone_package(): Clones a package object
-static void lai_clone_package(lai_variable_t *dest, lai_variable_t *src) {
-    size_t n = src->pkg_ptr->size;
-    if (lai_create_pkg(dest, n) != LAI_ERROR_NONE)
+// lai_clone_package(): Clones a package object (without copying its elements)
+static void lai_clone_package(lai_variable_t *dest, lai_variable_t *source) {
+    struct lai_pkg_head *head = source->pkg_ptr;
+    if (!head->shared) {
+        struct lai_pkg_head *storage = lai_slab_alloc(LAI_SLAB_PKG_HEAD);
+        if (!storage)
+            lai_panic("unable to allocate memory for package object.");
+        storage->rc = 1;
+        storage->size = head->size;
+        storage->elems = head->elems;
+        storage->shared = NULL;
+        storage->block = NULL;
+        storage->elems_block = head->elems_block;
+        storage->capacity = head->capacity;
+        head->elems_block = NULL;
+        head->shared = storage;
+    }
+
+    struct lai_pkg_head *clone = lai_slab_alloc(LAI_SLAB_PKG_HEAD);
+    if (!clone)
+        lai_panic("unable to allocate memory for package object.");
+    clone->rc = 1;
+    clone->size = head->size;
+    clone->elems = head->elems;
+    clone->shared = head->shared;
+    clone->block = NULL;
+    clone->elems_block = NULL;
+    clone->capacity = head->capacity;
+    lai_rc_ref(&head->shared->rc);
+    dest->type = LAI_PACKAGE;
+    dest->pkg_ptr = clone;
+}
+
+// If head is the last head that borrows the content, it takes over the content.
+// Otherwise, it gets a private copy.
+
+void lai_exec_unshare_string_slow(struct lai_string_head *head) {
+    struct lai_string_head *storage = head->shared;
+    head->shared = NULL;
+    if (storage->content == storage->inline_content) {
+        memcpy(head->inline_content, storage->content, storage->capacity);
+        head->content = head->inline_content;
+        head->in_arena = 0;
+        lai_exec_unref_string(storage);
+        return;
+    }
+    if (storage->rc == 1) {
+        head->in_arena = storage->in_arena;
+        lai_slab_free(LAI_SLAB_STRING_HEAD, storage);
+        return;
+    }
+
+    char *content = laihost_malloc(storage->capacity);
+    if (!content)
+        lai_panic("unable to allocate memory for string object.");
+    memcpy(content, storage->content, storage->capacity);
+    head->content = content;
+    head->in_arena = 0;
+    lai_exec_unref_string(storage);
+}
+
+void lai_exec_unshare_buffer_slow(struct lai_buffer_head *head) {
+    struct lai_buffer_head *storage = head->shared;
+    head->shared = NULL;
+    if (storage->content == storage->inline_content) {
+        memcpy(head->inline_content, storage->content, storage->size);
+        head->content = head->inline_content;
+        head->in_arena = 0;
+        lai_exec_unref_buffer(storage);
+        return;
+    }
+    if (storage->rc == 1) {
+        head->in_arena = storage->in_arena;
+        lai_slab_free(LAI_SLAB_BUFFER_HEAD, storage);
+        return;
+    }
+
+    uint8_t *content = laihost_malloc(storage->size);
+    if (!content)
+        lai_panic("unable to allocate memory for buffer object.");
+    memcpy(content, storage->content, storage->size);
+    head->content = content;
+    head->in_arena = 0;
+    lai_exec_unref_buffer(storage);
+}
+
+void lai_exec_unshare_pkg_slow(struct lai_pkg_head *head) {
+    struct lai_pkg_head *storage = head->shared;
+    head->shared = NULL;
+    if (storage->rc == 1) {
+        head->elems_block = storage->elems_block;
+        head->capacity = storage->capacity;
+        lai_slab_free(LAI_SLAB_PKG_HEAD, storage);
+        return;
+    }
+
+    // Elements are cloned; hence, nested objects are only copied when they are mutated.
+    lai_variable_t *elems = laihost_malloc(storage->size * sizeof(lai_variable_t));
+    if (!elems)
         lai_panic("unable to allocate memory for package object.");
-    for (size_t i = 0; i < n; i++)
-        lai_obj_clone(&dest->pkg_ptr->elems[i], &src->pkg_ptr->elems[i]);
+    memset(elems, 0, storage->size * sizeof(lai_variable_t));
+    for (size_t i = 0; i < storage->size; i++)
+        lai_obj_clone(&elems[i], &storage->elems[i]);
+    head->elems = elems;
+    head->capacity = storage->size;
+    lai_exec_unref_pkg(storage);
+}
+
+static void lai_exec_promote_string(struct lai_string_head *head) {
+    if (head->shared) {
+        if (!head->shared->in_arena)
+            return;
+        lai_exec_unshare_string_slow(head);
+    }
+    if (!head->in_arena)
+        return;
+
+    char *content = laihost_malloc(head->capacity);
+    if (!content)
+        lai_panic("unable to allocate memory for string object.");
+    memcpy(content, head->content, head->capacity);
+    lai_exec_arena_free(head->content);
+    head->content = content;
+    head->in_arena = 0;
+}
+
+static void lai_exec_promote_buffer(struct lai_buffer_head *head) {
+    if (head->shared) {
+        if (!head->shared->in_arena)
+            return;
+        lai_exec_unshare_buffer_slow(head);
+    }
+    if (!head->in_arena)
+        return;
+
+    uint8_t *content = laihost_malloc(head->size);
+    if (!content)
+        lai_panic("unable to allocate memory for buffer object.");
+    memcpy(content, head->content, head->size);
+    lai_exec_arena_free(head->content);
+    head->content = content;
+    head->in_arena = 0;
+}
+
+// Replacing the content of a head does not change the value of the object; hence,
+// heads that are shared with other objects are promoted in-place.
+void lai_exec_promote(lai_variable_t *object) {
+    switch (object->type) {
+        case LAI_STRING:
+        case LAI_STRING_INDEX:
+            lai_exec_promote_string(object->string_ptr);
+            break;
+        case LAI_BUFFER:
+        case LAI_BUFFER_INDEX:
+            lai_exec_promote_buffer(object->buffer_ptr);
+            break;
+        case LAI_PACKAGE:
+        case LAI_PACKAGE_INDEX:
+            for (size_t i = 0; i < object->pkg_ptr->size; i++)
+                lai_exec_promote(&object->pkg_ptr->elems[i]);
+            break;
+    }
 }
 
 extern void lai_swap_object(lai_variable_t *first, lai_variable_t *second); // from core/variable.c
@@ -732,6 +1129,30 @@ void lai_obj_clone(lai_variable_t *dest, lai_variable_t *source) {
     }
 }
 
+void lai_exec_move_result(lai_variable_t *dest, lai_variable_t *source) {
+    int shared;
+    switch (source->type) {
+        case LAI_STRING:
+            shared = source->string_ptr->rc > 1;
+            break;
+        case LAI_BUFFER:
+            shared = source->buffer_ptr->rc > 1;
+            break;
+        case LAI_PACKAGE:
+            shared = source->pkg_ptr->rc > 1;
+            break;
+        default:
+            shared = 0;
+    }
+
+    if (shared) {
+        lai_obj_clone(dest, source);
+        lai_var_finalize(source);
+    } else {
+        lai_var_move(dest, source);
+    }
+}
+
 int lai_objecttype_obj(lai_variable_t *var) {
     switch (var->type) {
         case LAI_INTEGER:
@@ -112,8 +112,7 @@ static void lai_get_pci_params(lai_nsnode_t *opregion, uint64_t *seg, uint64_t *
     LAI_CLEANUP_VAR lai_variable_t seg_number = LAI_VAR_INITIALIZER;
     LAI_CLEANUP_VAR lai_variable_t address_number = LAI_VAR_INITIALIZER;
 
-    LAI_CLEANUP_STATE lai_state_t state;
-    lai_init_state(&state); // XXX: take the state as an argument instead?
+    LAI_CLEANUP_ACQUIRED_STATE lai_state_t *state = lai_acquire_state();
 
     lai_nsnode_t *device = lai_ns_get_parent(opregion);
     if (!device)
@@ -123,14 +122,14 @@ static void lai_get_pci_params(lai_nsnode_t *opregion, uint64_t *seg, uint64_t *
     if (!bus)
         lai_panic("lai_get_pci_params: Couldn't get bus");
 
-    lai_nsnode_t *root_bus = lai_find_parent_root_of(bus, &state);
+    lai_nsnode_t *root_bus = lai_find_parent_root_of(bus, state);
     if (!root_bus)
         lai_panic("lai_get_pci_params: Couldn't get root bus");
 
     // PCI seg number is in the _SEG object.
     lai_nsnode_t *seg_handle = lai_resolve_search(root_bus, "_SEG");
     if (seg_handle) {
-        if (lai_eval(&seg_number, seg_handle, &state))
+        if (lai_eval(&seg_number, seg_handle, state))
             lai_panic("could not evaluate _SEG of OperationRegion()");
         if (seg)
             *seg = seg_number.integer;
@@ -139,7 +138,7 @@ static void lai_get_pci_params(lai_nsnode_t *opregion, uint64_t *seg, uint64_t *
     // PCI bus number is in the _BBN object.
     lai_nsnode_t *bbn_handle = lai_resolve_search(root_bus, "_BBN");
     if (bbn_handle) {
-        if (lai_eval(&bus_number, bbn_handle, &state))
+        if (lai_eval(&bus_number, bbn_handle, state))
             lai_panic("could not evaluate _BBN of OperationRegion()");
         if (bbn)
             *bbn = bus_number.integer;
@@ -148,7 +147,7 @@ static void lai_get_pci_params(lai_nsnode_t *opregion, uint64_t *seg, uint64_t *
     // Device slot/function is in the _ADR object.
     lai_nsnode_t *adr_handle = lai_resolve_search(opregion, "_ADR");
     if (adr_handle) {
-        if (lai_eval(&address_number, adr_handle, &state))
+        if (lai_eval(&address_number, adr_handle, state))
             lai_panic("could not evaluate _ADR of OperationRegion()");
         if (adr)
             *adr = address_number.integer;
@@ -165,27 +164,28 @@ static uint64_t lai_perform_read(lai_nsnode_t *opregion, size_t access_size, siz
     struct lai_instance *instance = lai_current_instance();
     uint64_t value = 0;
 
-    if (opregion->op_override) {
+    struct lai_nsnode_overrides *overrides = lai_ns_get_overrides(opregion);
+    if (overrides && overrides->op_override) {
         if (instance->trace & LAI_TRACE_IO)
             lai_debug("lai_perform_read: %lu-bit read from overridden opregion at %lx (address "
                       "space %02u)",
                       access_size, opregion->op_base + offset, opregion->op_address_space);
         switch (access_size) {
             case 8:
-                value = opregion->op_override->readb(opregion->op_base + offset,
-                                                     opregion->op_userptr);
+                value = overrides->op_override->readb(opregion->op_base + offset,
+                                                      overrides->op_userptr);
                 break;
             case 16:
-                value = opregion->op_override->readw(opregion->op_base + offset,
-                                                     opregion->op_userptr);
+                value = overrides->op_override->readw(opregion->op_base + offset,
+                                                      overrides->op_userptr);
                 break;
             case 32:
-                value = opregion->op_override->readd(opregion->op_base + offset,
-                                                     opregion->op_userptr);
+                value = overrides->op_override->readd(opregion->op_base + offset,
+                                                      overrides->op_userptr);
                 break;
             case 64:
-                value = opregion->op_override->readq(opregion->op_base + offset,
-                                                     opregion->op_userptr);
+                value = overrides->op_override->readq(opregion->op_base + offset,
+                                                      overrides->op_userptr);
                 break;
             default:
                 lai_panic("invalid access size");
@@ -279,27 +279,29 @@ static uint64_t lai_perform_read(lai_nsnode_t *opregion, size_t access_size, siz
 static void lai_perform_write(lai_nsnode_t *opregion, size_t access_size, size_t offset,
                               uint64_t seg, uint64_t bbn, uint64_t adr, uint64_t value) {
     struct lai_instance *instance = lai_current_instance();
-    if (opregion->op_override) {
+
+    struct lai_nsnode_overrides *overrides = lai_ns_get_overrides(opregion);
+    if (overrides && overrides->op_override) {
         if (instance->trace & LAI_TRACE_IO)
             lai_debug("lai_perform_write: %lu-bit write of %lx to overridden opregion at %lx "
                       "(address space %02u)",
                       access_size, opregion->op_base + offset, value, opregion->op_address_space);
         switch (access_size) {
             case 8:
-                opregion->op_override->writeb(opregion->op_base + offset, value,
-                                              opregion->op_userptr);
+                overrides->op_override->writeb(opregion->op_base + offset, value,
+                                               overrides->op_userptr);
                 break;
             case 16:
-                opregion->op_override->writew(opregion->op_base + offset, value,
-                                              opregion->op_userptr);
+                overrides->op_override->writew(opregion->op_base + offset, value,
+                                               overrides->op_userptr);
                 break;
             case 32:
-                opregion->op_override->writed(opregion->op_base + offset, value,
-                                              opregion->op_userptr);
+                overrides->op_override->writed(opregion->op_base + offset, value,
+                                               overrides->op_userptr);
                 break;
             case 64:
-                opregion->op_override->writeq(opregion->op_base + offset, value,
-                                              opregion->op_userptr);
+                overrides->op_override->writeq(opregion->op_base + offset, value,
+                                               overrides->op_userptr);
                 break;
             default:
                 lai_panic("invalid access size");
@@ -508,25 +510,27 @@ void lai_write_field(lai_nsnode_t *field, lai_variable_t *source) {
  *        to change the offset. Take care of that for that in
  *        lai_{read,write}_field_internal? */
 
-void lai_read_indexfield(lai_variable_t *dest, lai_nsnode_t *idxf) {
-    lai_nsnode_t *index_field = idxf->idxf_index_node;
-    lai_nsnode_t *data_field = idxf->idxf_data_node;
+void lai_read_indexfield(lai_variable_t *dest, lai_nsnode_t *node) {
+    struct lai_index_field *idxf = node->idxf;
+    lai_nsnode_t *index_field = idxf->index_node;
+    lai_nsnode_t *data_field = idxf->data_node;
 
     lai_variable_t index = {0};
     index.type = LAI_INTEGER;
-    index.integer = idxf->idxf_offset / 8; // Always byte-aligned.
+    index.integer = idxf->offset / 8; // Always byte-aligned.
 
     lai_write_field(index_field, &index); // Write index register.
     lai_read_field(dest, data_field); // Read data register.
 }
 
-void lai_write_indexfield(lai_nsnode_t *idxf, lai_variable_t *src) {
-    lai_nsnode_t *index_field = idxf->idxf_index_node;
-    lai_nsnode_t *data_field = idxf->idxf_data_node;
+void lai_write_indexfield(lai_nsnode_t *node, lai_variable_t *src) {
+    struct lai_index_field *idxf = node->idxf;
+    lai_nsnode_t *index_field = idxf->index_node;
+    lai_nsnode_t *data_field = idxf->data_node;
 
     lai_variable_t index = {0};
     index.type = LAI_INTEGER;
-    index.integer = idxf->idxf_offset / 8; // Always byte-aligned.
+    index.integer = idxf->offset / 8; // Always byte-aligned.
 
     lai_write_field(index_field, &index); // Write index register.
     lai_write_field(data_field, src); // Write data register.
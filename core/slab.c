@@ -0,0 +1,154 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2021 The lai authors
+ */
+
+/* Slab allocator for LAI's fixed-size objects.
+ * Objects are carved out of larger host allocations (slabs), such that namespace creation
+ * and method invocation do not need to call into the host allocator for every object.
+ * Each object type has its own cache; freed objects are kept on a per-cache free list.
+ * Caches are part of struct lai_instance. */
+
+#include <lai/core.h>
+
+#include "libc.h"
+#include "slab.h"
+
+// Size of each slab, unless objects are so large that fewer than LAI_SLAB_MIN_OBJECTS fit.
+#define LAI_SLAB_SIZE 4096
+#define LAI_SLAB_MIN_OBJECTS 8
+// Object sizes are rounded up to a multiple of this (or of the type's own alignment).
+#define LAI_SLAB_ALIGN 16
+
+struct lai_slab {
+    struct lai_slab *next;
+    size_t size;
+};
+
+// Objects start after the (aligned) slab header.
+#define LAI_SLAB_HEADER_SIZE                                                                       \
+    ((sizeof(struct lai_slab) + LAI_SLAB_ALIGN - 1) & ~(size_t)(LAI_SLAB_ALIGN - 1))
+
+struct lai_slab_free_object {
+    struct lai_slab_free_object *next;
+};
+
+static const struct {
+    const char *name;
+    size_t size;
+    size_t align; // Zero means LAI_SLAB_ALIGN.
+} lai_slab_types[LAI_SLAB_NUM_CACHES] = {
+    // Namespace nodes are aligned to cache lines, see the comment in lai_nsnode_t.
+    [LAI_SLAB_NSNODE] = {"nsnode", sizeof(lai_nsnode_t), 64},
+    [LAI_SLAB_STRING_HEAD] = {"string_head", sizeof(struct lai_string_head)},
+    [LAI_SLAB_BUFFER_HEAD] = {"buffer_head", sizeof(struct lai_buffer_head)},
+    [LAI_SLAB_PKG_HEAD] = {"pkg_head", sizeof(struct lai_pkg_head)},
+    [LAI_SLAB_LAZY_HANDLE] = {"lazy_handle", sizeof(struct lai_lazy_handle)},
+    [LAI_SLAB_INVOCATION] = {"invocation", sizeof(struct lai_invocation)},
+};
+
+static inline size_t lai_slab_object_align(enum lai_slab_cache_id id) {
+    return lai_slab_types[id].align ? lai_slab_types[id].align : LAI_SLAB_ALIGN;
+}
+
+static inline size_t lai_slab_object_size(enum lai_slab_cache_id id) {
+    size_t align = lai_slab_object_align(id);
+    return (lai_slab_types[id].size + align - 1) & ~(align - 1);
+}
+
+static int lai_slab_refill(struct lai_slab_cache *cache, enum lai_slab_cache_id id) {
+    size_t object_size = lai_slab_object_size(id);
+    size_t align = lai_slab_object_align(id);
+    // The host only guarantees LAI_SLAB_ALIGN, reserve enough space to align the first object.
+    size_t overhead = LAI_SLAB_HEADER_SIZE + align - LAI_SLAB_ALIGN;
+    size_t size = LAI_SLAB_SIZE;
+    if (size < overhead + LAI_SLAB_MIN_OBJECTS * object_size)
+        size = overhead + LAI_SLAB_MIN_OBJECTS * object_size;
+
+    struct lai_slab *slab = laihost_malloc(size);
+    if (!slab)
+        return 1;
+    slab->next = cache->slabs;
+    slab->size = size;
+    cache->slabs = slab;
+
+    // Push all objects to the free list, in reverse order such that they are
+    // handed out in address order.
+    uintptr_t start = (uintptr_t)slab + LAI_SLAB_HEADER_SIZE;
+    uint8_t *base = (uint8_t *)((start + align - 1) & ~(uintptr_t)(align - 1));
+    size_t n = (size - (base - (uint8_t *)slab)) / object_size;
+    for (size_t i = n; i-- > 0;) {
+        struct lai_slab_free_object *object = (void *)(base + i * object_size);
+        object->next = cache->free_list;
+        cache->free_list = object;
+    }
+
+    cache->stats.name = lai_slab_types[id].name;
+    cache->stats.object_size = object_size;
+    cache->stats.num_slabs++;
+    cache->stats.objects_free += n;
+    return 0;
+}
+
+void *lai_slab_alloc(enum lai_slab_cache_id id) {
+    LAI_ENSURE(id < LAI_SLAB_NUM_CACHES);
+    struct lai_slab_cache *cache = &lai_current_instance()->slab_caches[id];
+
+    if (!cache->free_list && lai_slab_refill(cache, id))
+        return NULL;
+
+    struct lai_slab_free_object *object = cache->free_list;
+    cache->free_list = object->next;
+    cache->stats.objects_free--;
+    cache->stats.objects_in_use++;
+    cache->stats.num_allocs++;
+    return object;
+}
+
+void lai_slab_free(enum lai_slab_cache_id id, void *ptr) {
+    LAI_ENSURE(id < LAI_SLAB_NUM_CACHES);
+    struct lai_slab_cache *cache = &lai_current_instance()->slab_caches[id];
+    if (!ptr)
+        return;
+
+    LAI_ENSURE(cache->stats.objects_in_use);
+    struct lai_slab_free_object *object = ptr;
+    object->next = cache->free_list;
+    cache->free_list = object;
+    cache->stats.objects_free++;
+    cache->stats.objects_in_use--;
+    cache->stats.num_frees++;
+}
+
+lai_api_error_t lai_slab_get_stats(enum lai_slab_cache_id id, struct lai_slab_stats *stats) {
+    if (id >= LAI_SLAB_NUM_CACHES)
+        return LAI_ERROR_ILLEGAL_ARGUMENTS;
+
+    *stats = lai_current_instance()->slab_caches[id].stats;
+    stats->name = lai_slab_types[id].name;
+    stats->object_size = lai_slab_object_size(id);
+    return LAI_ERROR_NONE;
+}
+
+void lai_slab_trim(void) {
+    struct lai_instance *instance = lai_current_instance();
+
+    for (int id = 0; id < LAI_SLAB_NUM_CACHES; id++) {
+        struct lai_slab_cache *cache = &instance->slab_caches[id];
+        // We do not know which slab a free object belongs to, hence we can only
+        // release slabs if the entire cache is unused.
+        if (cache->stats.objects_in_use)
+            continue;
+
+        struct lai_slab *slab = cache->slabs;
+        while (slab) {
+            struct lai_slab *next = slab->next;
+            laihost_free(slab, slab->size);
+            slab = next;
+        }
+        cache->slabs = NULL;
+        cache->free_list = NULL;
+        cache->stats.num_slabs = 0;
+        cache->stats.objects_free = 0;
+    }
+}
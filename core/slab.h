@@ -0,0 +1,15 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2021 The lai authors
+ */
+
+#pragma once
+
+#include <lai/core.h>
+
+// LAI internal header
+
+// Allocates an (uninitialized) object from one of the slab caches.
+// Returns NULL if the host is out of memory.
+void *lai_slab_alloc(enum lai_slab_cache_id);
+void lai_slab_free(enum lai_slab_cache_id, void *);
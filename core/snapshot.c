@@ -0,0 +1,788 @@
+/*
+ * Lightweight AML Interpreter
+ * Copyright (C) 2018-2021 The lai authors
+ */
+
+/* Namespace snapshots.
+ * lai_save_namespace() serializes the namespace that was built by lai_create_namespace()
+ * into a position-independent image. On the next boot, lai_load_namespace() rebuilds the
+ * namespace from the image in a single pass, without running the interpreter.
+ *
+ * Images store references to nodes as node IDs and references into AML code as
+ * (table ID, offset). The node records are followed by the order in which the nodes are
+ * installed; this preserves the definition order of the children of each node.
+ * Images are keyed by a hash of the headers (including the checksums) of all AML tables;
+ * images that do not match the firmware's tables are rejected.
+ * Host overrides (lai_ns_override_notify(), lai_ns_override_opregion()) are not part of
+ * the image and need to be installed again after loading. */
+
+#include <lai/core.h>
+
+#include "exec_impl.h"
+#include "libc.h"
+#include "ns_impl.h"
+
+int lai_do_osi_method(lai_variable_t *args, lai_variable_t *result);
+int lai_do_os_method(lai_variable_t *args, lai_variable_t *result);
+int lai_do_rev_method(lai_variable_t *args, lai_variable_t *result);
+
+#define LAI_SNAPSHOT_MAGIC 0x534E494C // "LINS", little endian.
+#define LAI_SNAPSHOT_VERSION 2
+#define LAI_SNAPSHOT_NONE 0xFFFFFFFF
+// The root node is not part of ns_array and is not stored in the image.
+#define LAI_SNAPSHOT_ROOT 0xFFFFFFFE
+
+// Methods without AML code, see lai_create_root().
+#define LAI_SNAPSHOT_METHOD_AML 0
+#define LAI_SNAPSHOT_METHOD_OSI 1
+#define LAI_SNAPSHOT_METHOD_OS 2
+#define LAI_SNAPSHOT_METHOD_REV 3
+
+struct lai_snapshot_header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key; // Hash of the AML table headers.
+    uint64_t payload_hash; // Hash of everything following the header.
+    uint32_t num_tables;
+    uint32_t num_nodes;
+};
+
+// AML tables in the order in which lai_create_namespace() loads them.
+struct lai_snapshot_tables {
+    acpi_aml_t **tables;
+    size_t *indices; // Index argument of lai_load_table().
+    size_t num_tables;
+    size_t capacity;
+};
+
+// Maps the buffers of Name() objects to their nodes. This is an open addressing hash table
+// that is keyed by the buffer head.
+struct lai_snapshot_buffer_owners {
+    struct lai_buffer_head **buffers;
+    lai_nsnode_t **nodes;
+    size_t capacity; // Power of two (or zero if there are no buffer fields).
+};
+
+// Serializes into data if it is non-NULL; otherwise, only the size is computed.
+struct lai_snapshot_writer {
+    uint8_t *data;
+    size_t offset;
+    uint32_t *node_ids; // Indexed by lai_nsnode_t::ns_index.
+    struct lai_snapshot_tables *tables;
+    struct lai_snapshot_buffer_owners buffer_owners;
+    int stale_reference; // Set if we encounter a reference to an uninstalled node.
+};
+
+struct lai_snapshot_reader {
+    const uint8_t *data;
+    size_t size;
+    size_t offset;
+    lai_nsnode_t *root_node;
+    lai_nsnode_t **nodes; // Indexed by node ID.
+    uint32_t num_nodes;
+    struct lai_aml_segment **segments; // Indexed by table ID.
+    struct lai_snapshot_tables *tables;
+};
+
+// Processes 8 bytes at a time; images can be large and are hashed on every boot.
+static uint64_t lai_snapshot_hash(uint64_t hash, const void *data, size_t size) {
+    const uint8_t *p = data;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, p + i, 8);
+        hash = (hash ^ word) * 0x100000001B3;
+        hash ^= hash >> 32;
+    }
+    for (; i < size; i++)
+        hash = (hash ^ p[i]) * 0x100000001B3;
+    return hash;
+}
+
+static int lai_snapshot_add_table(struct lai_snapshot_tables *tables, acpi_aml_t *table,
+                                  size_t index) {
+    if (tables->num_tables == tables->capacity) {
+        size_t new_capacity = tables->capacity ? 2 * tables->capacity : 8;
+        acpi_aml_t **new_tables = laihost_realloc(tables->tables,
+                                                  new_capacity * sizeof(acpi_aml_t *),
+                                                  tables->capacity * sizeof(acpi_aml_t *));
+        if (!new_tables)
+            return 1;
+        tables->tables = new_tables;
+        size_t *new_indices = laihost_realloc(tables->indices, new_capacity * sizeof(size_t),
+                                              tables->capacity * sizeof(size_t));
+        if (!new_indices)
+            return 1;
+        tables->indices = new_indices;
+        tables->capacity = new_capacity;
+    }
+    tables->tables[tables->num_tables] = table;
+    tables->indices[tables->num_tables] = index;
+    tables->num_tables++;
+    return 0;
+}
+
+static void lai_snapshot_free_tables(struct lai_snapshot_tables *tables) {
+    if (tables->capacity) {
+        laihost_free(tables->tables, tables->capacity * sizeof(acpi_aml_t *));
+        laihost_free(tables->indices, tables->capacity * sizeof(size_t));
+    }
+}
+
+// Must agree with lai_create_namespace().
+static lai_api_error_t lai_snapshot_scan_tables(struct lai_snapshot_tables *tables,
+                                                uint64_t *key) {
+    acpi_aml_t *table = laihost_scan("DSDT", 0);
+    if (!table)
+        return LAI_ERROR_NO_SUCH_NODE;
+    if (lai_snapshot_add_table(tables, table, 0))
+        return LAI_ERROR_OUT_OF_MEMORY;
+
+    for (size_t index = 0; (table = laihost_scan("SSDT", index)); index++) {
+        if (lai_snapshot_add_table(tables, table, index))
+            return LAI_ERROR_OUT_OF_MEMORY;
+    }
+    for (size_t index = 0; (table = laihost_scan("PSDT", index)); index++) {
+        if (lai_snapshot_add_table(tables, table, index))
+            return LAI_ERROR_OUT_OF_MEMORY;
+    }
+
+    uint64_t hash = 0xCBF29CE484222325;
+    for (size_t i = 0; i < tables->num_tables; i++)
+        hash = lai_snapshot_hash(hash, &tables->tables[i]->header, sizeof(acpi_header_t));
+    *key = hash;
+    return LAI_ERROR_NONE;
+}
+
+//---------------------------------------------------------------------------------------
+// Serialization.
+//---------------------------------------------------------------------------------------
+
+static void lai_snapshot_put(struct lai_snapshot_writer *writer, const void *p, size_t size) {
+    if (writer->data)
+        memcpy(writer->data + writer->offset, p, size);
+    writer->offset += size;
+}
+
+static void lai_snapshot_put_u8(struct lai_snapshot_writer *writer, uint8_t value) {
+    lai_snapshot_put(writer, &value, 1);
+}
+
+static void lai_snapshot_put_u32(struct lai_snapshot_writer *writer, uint32_t value) {
+    lai_snapshot_put(writer, &value, 4);
+}
+
+static void lai_snapshot_put_u64(struct lai_snapshot_writer *writer, uint64_t value) {
+    lai_snapshot_put(writer, &value, 8);
+}
+
+static void lai_snapshot_put_node(struct lai_snapshot_writer *writer, lai_nsnode_t *node) {
+    struct lai_instance *instance = lai_current_instance();
+    if (!node) {
+        lai_snapshot_put_u32(writer, LAI_SNAPSHOT_NONE);
+        return;
+    }
+    if (node == instance->root_node) {
+        lai_snapshot_put_u32(writer, LAI_SNAPSHOT_ROOT);
+        return;
+    }
+    if (node->ns_index >= instance->ns_size || instance->ns_array[node->ns_index] != node) {
+        writer->stale_reference = 1;
+        lai_snapshot_put_u32(writer, LAI_SNAPSHOT_NONE);
+        return;
+    }
+    lai_snapshot_put_u32(writer, writer->node_ids[node->ns_index]);
+}
+
+// Stores a pointer into AML code as (table ID, offset).
+static lai_api_error_t lai_snapshot_put_aml(struct lai_snapshot_writer *writer,
+                                            const uint8_t *aml) {
+    for (size_t i = 0; i < writer->tables->num_tables; i++) {
+        const uint8_t *table = (const uint8_t *)writer->tables->tables[i];
+        uint32_t length = writer->tables->tables[i]->header.length;
+        // Empty methods can end at the end of the table.
+        if (aml >= table && aml <= table + length) {
+            lai_snapshot_put_u32(writer, i);
+            lai_snapshot_put_u32(writer, aml - table);
+            return LAI_ERROR_NONE;
+        }
+    }
+    return LAI_ERROR_UNSUPPORTED;
+}
+
+static lai_api_error_t lai_snapshot_put_var(struct lai_snapshot_writer *writer,
+                                            lai_variable_t *var) {
+    lai_snapshot_put_u8(writer, var->type);
+    switch (var->type) {
+        case 0:
+            break;
+        case LAI_INTEGER:
+            lai_snapshot_put_u64(writer, var->integer);
+            break;
+        case LAI_STRING: {
+            size_t length = lai_exec_string_length(var);
+            lai_snapshot_put_u64(writer, length);
+            lai_snapshot_put(writer, lai_exec_string_access(var), length);
+            break;
+        }
+        case LAI_BUFFER: {
+            size_t size = lai_exec_buffer_size(var);
+            lai_snapshot_put_u64(writer, size);
+            lai_snapshot_put(writer, lai_exec_buffer_access(var), size);
+            break;
+        }
+        case LAI_PACKAGE: {
+            size_t size = lai_exec_pkg_size(var);
+            lai_snapshot_put_u32(writer, size);
+            for (size_t i = 0; i < size; i++) {
+                lai_api_error_t error = lai_snapshot_put_var(writer, &var->pkg_ptr->elems[i]);
+                if (error)
+                    return error;
+            }
+            break;
+        }
+        case LAI_HANDLE:
+            lai_snapshot_put_node(writer, var->handle);
+            break;
+        case LAI_LAZY_HANDLE:
+            lai_snapshot_put_node(writer, var->lazy_ptr->ctx_handle);
+            return lai_snapshot_put_aml(writer, var->lazy_ptr->aml);
+        default:
+            // References and indices only exist while methods run.
+            return LAI_ERROR_UNSUPPORTED;
+    }
+    return LAI_ERROR_NONE;
+}
+
+static inline size_t lai_snapshot_buffer_slot(struct lai_snapshot_buffer_owners *owners,
+                                              struct lai_buffer_head *buffer) {
+    uint64_t key = (uint64_t)(uintptr_t)buffer >> 4; // Heads are at least 16-byte aligned.
+    return (size_t)((key * 0x9E3779B97F4A7C15) >> 32) & (owners->capacity - 1);
+}
+
+// Collects the buffers of all Name() objects, such that buffer fields can find their owners
+// without a walk of the namespace. Does nothing if there are no buffer fields.
+static lai_api_error_t lai_snapshot_build_buffer_owners(struct lai_snapshot_buffer_owners *owners,
+                                                        size_t num_buffer_fields) {
+    if (!num_buffer_fields)
+        return LAI_ERROR_NONE;
+
+    size_t num_buffers = 0;
+    struct lai_ns_iterator iter = LAI_NS_ITERATOR_INITIALIZER;
+    lai_nsnode_t *node;
+    while ((node = lai_ns_iterate(&iter))) {
+        if (node->type == LAI_NAMESPACE_NAME && node->object.type == LAI_BUFFER)
+            num_buffers++;
+    }
+
+    size_t capacity = 16;
+    while (capacity < 2 * num_buffers)
+        capacity *= 2;
+    owners->capacity = capacity;
+    owners->buffers = laihost_malloc(capacity * sizeof(struct lai_buffer_head *));
+    owners->nodes = laihost_malloc(capacity * sizeof(lai_nsnode_t *));
+    if (!owners->buffers || !owners->nodes)
+        return LAI_ERROR_OUT_OF_MEMORY;
+    memset(owners->buffers, 0, capacity * sizeof(struct lai_buffer_head *));
+
+    lai_initialize_ns_iterator(&iter);
+    while ((node = lai_ns_iterate(&iter))) {
+        if (node->type != LAI_NAMESPACE_NAME || node->object.type != LAI_BUFFER)
+            continue;
+        struct lai_buffer_head *buffer = node->object.buffer_ptr;
+        size_t k = lai_snapshot_buffer_slot(owners, buffer);
+        while (owners->buffers[k] && owners->buffers[k] != buffer)
+            k = (k + 1) & (capacity - 1);
+        // If multiple nodes share a buffer, the first one in iteration order is the owner.
+        if (!owners->buffers[k]) {
+            owners->buffers[k] = buffer;
+            owners->nodes[k] = node;
+        }
+    }
+    return LAI_ERROR_NONE;
+}
+
+static void lai_snapshot_free_buffer_owners(struct lai_snapshot_buffer_owners *owners) {
+    if (owners->buffers)
+        laihost_free(owners->buffers, owners->capacity * sizeof(struct lai_buffer_head *));
+    if (owners->nodes)
+        laihost_free(owners->nodes, owners->capacity * sizeof(lai_nsnode_t *));
+}
+
+// Returns the Name() whose buffer is the target of a buffer field (or NULL).
+static lai_nsnode_t *lai_snapshot_find_buffer_owner(struct lai_snapshot_buffer_owners *owners,
+                                                    struct lai_buffer_head *buffer) {
+    if (!owners->capacity)
+        return NULL;
+    size_t k = lai_snapshot_buffer_slot(owners, buffer);
+    while (owners->buffers[k]) {
+        if (owners->buffers[k] == buffer)
+            return owners->nodes[k];
+        k = (k + 1) & (owners->capacity - 1);
+    }
+    return NULL;
+}
+
+static lai_api_error_t lai_snapshot_put_nsnode(struct lai_snapshot_writer *writer,
+                                               lai_nsnode_t *node) {
+    struct lai_nsnode_overrides *overrides;
+    lai_api_error_t error;
+
+    lai_snapshot_put(writer, node->name, 4);
+    lai_snapshot_put_u8(writer, node->type);
+    lai_snapshot_put_node(writer, node->parent);
+
+    switch (node->type) {
+        case LAI_NAMESPACE_METHOD:
+            overrides = lai_ns_get_overrides(node);
+            if (overrides && overrides->method_override) {
+                if (overrides->method_override == &lai_do_osi_method)
+                    lai_snapshot_put_u8(writer, LAI_SNAPSHOT_METHOD_OSI);
+                else if (overrides->method_override == &lai_do_os_method)
+                    lai_snapshot_put_u8(writer, LAI_SNAPSHOT_METHOD_OS);
+                else if (overrides->method_override == &lai_do_rev_method)
+                    lai_snapshot_put_u8(writer, LAI_SNAPSHOT_METHOD_REV);
+                else
+                    return LAI_ERROR_UNSUPPORTED;
+            } else {
+                lai_snapshot_put_u8(writer, LAI_SNAPSHOT_METHOD_AML);
+                if ((error = lai_snapshot_put_aml(writer, node->pointer)))
+                    return error;
+                lai_snapshot_put_u32(writer, node->size);
+            }
+            lai_snapshot_put_u8(writer, node->method_flags);
+            break;
+        case LAI_NAMESPACE_ALIAS:
+            lai_snapshot_put_node(writer, node->al_target);
+            break;
+        case LAI_NAMESPACE_FIELD:
+            lai_snapshot_put_node(writer, node->fld_region_node);
+            lai_snapshot_put_u64(writer, node->fld_offset);
+            lai_snapshot_put_u32(writer, node->fld_size);
+            lai_snapshot_put_u8(writer, node->fld_flags);
+            break;
+        case LAI_NAMESPACE_INDEXFIELD:
+            lai_snapshot_put_node(writer, node->idxf->index_node);
+            lai_snapshot_put_node(writer, node->idxf->data_node);
+            lai_snapshot_put_u64(writer, node->idxf->offset);
+            lai_snapshot_put_u8(writer, node->idxf->flags);
+            lai_snapshot_put_u8(writer, node->idxf->size);
+            break;
+        case LAI_NAMESPACE_BANK_FIELD:
+            lai_snapshot_put_node(writer, node->bkf->region_node);
+            lai_snapshot_put_node(writer, node->bkf->bank_node);
+            lai_snapshot_put_u64(writer, node->bkf->offset);
+            lai_snapshot_put_u64(writer, node->bkf->value);
+            lai_snapshot_put_u8(writer, node->bkf->flags);
+            lai_snapshot_put_u8(writer, node->bkf->size);
+            break;
+        case LAI_NAMESPACE_BUFFER_FIELD: {
+            // Buffer fields usually alias the buffer of a Name(); preserve that.
+            lai_nsnode_t *owner
+                = lai_snapshot_find_buffer_owner(&writer->buffer_owners, node->bf_buffer);
+            lai_snapshot_put_node(writer, owner);
+            if (!owner) {
+                lai_snapshot_put_u64(writer, node->bf_buffer->size);
+                lai_snapshot_put(writer, node->bf_buffer->content, node->bf_buffer->size);
+            }
+            lai_snapshot_put_u64(writer, node->bf_offset);
+            lai_snapshot_put_u64(writer, node->bf_size);
+            break;
+        }
+        case LAI_NAMESPACE_PROCESSOR:
+            lai_snapshot_put_u8(writer, node->cpu_id);
+            lai_snapshot_put_u32(writer, node->pblk_addr);
+            lai_snapshot_put_u8(writer, node->pblk_len);
+            break;
+        case LAI_NAMESPACE_OPREGION:
+            lai_snapshot_put_u64(writer, node->op_base);
+            lai_snapshot_put_u64(writer, node->op_length);
+            lai_snapshot_put_u8(writer, node->op_address_space);
+            break;
+    }
+
+    return lai_snapshot_put_var(writer, &node->object);
+}
+
+static lai_api_error_t lai_snapshot_put_nsnodes(struct lai_snapshot_writer *writer) {
+    lai_api_error_t error;
+
+    // Buffer fields come last, such that the Name()s that own their buffers already exist
+    // when the image is loaded.
+    for (int pass = 0; pass < 2; pass++) {
+        struct lai_ns_iterator iter = LAI_NS_ITERATOR_INITIALIZER;
+        lai_nsnode_t *node;
+        while ((node = lai_ns_iterate(&iter))) {
+            if ((node->type == LAI_NAMESPACE_BUFFER_FIELD) != pass)
+                continue;
+            if ((error = lai_snapshot_put_nsnode(writer, node)))
+                return error;
+        }
+    }
+    if (writer->stale_reference)
+        return LAI_ERROR_UNSUPPORTED;
+
+    // Parents before children, siblings in definition order.
+    lai_nsnode_t *root = lai_current_instance()->root_node;
+    lai_nsnode_t *node = root;
+    while ((node = lai_ns_preorder_next(root, node)))
+        lai_snapshot_put_node(writer, node);
+    return LAI_ERROR_NONE;
+}
+
+lai_api_error_t lai_save_namespace(void **image, size_t *size) {
+    struct lai_instance *instance = lai_current_instance();
+    if (!instance->root_node)
+        return LAI_ERROR_NO_SUCH_NODE;
+
+    lai_api_error_t error;
+    struct lai_snapshot_header header = {0};
+    struct lai_snapshot_tables tables = {0};
+    struct lai_snapshot_writer writer = {0};
+    uint8_t *data = NULL;
+    size_t data_size = 0;
+
+    if ((error = lai_snapshot_scan_tables(&tables, &header.key)))
+        goto out;
+
+    // Assign dense node IDs in iteration order.
+    writer.node_ids = laihost_malloc(instance->ns_size * sizeof(uint32_t));
+    if (!writer.node_ids) {
+        error = LAI_ERROR_OUT_OF_MEMORY;
+        goto out;
+    }
+    struct lai_ns_iterator iter = LAI_NS_ITERATOR_INITIALIZER;
+    lai_nsnode_t *node;
+    uint32_t num_nodes = 0;
+    size_t num_buffer_fields = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        lai_initialize_ns_iterator(&iter);
+        while ((node = lai_ns_iterate(&iter))) {
+            if ((node->type == LAI_NAMESPACE_BUFFER_FIELD) == pass) {
+                writer.node_ids[node->ns_index] = num_nodes++;
+                num_buffer_fields += pass;
+            }
+        }
+    }
+    writer.tables = &tables;
+
+    if ((error = lai_snapshot_build_buffer_owners(&writer.buffer_owners, num_buffer_fields)))
+        goto out;
+
+    // Compute the size first, then serialize.
+    if ((error = lai_snapshot_put_nsnodes(&writer)))
+        goto out;
+    data_size = sizeof(struct lai_snapshot_header) + writer.offset;
+    data = laihost_malloc(data_size);
+    if (!data) {
+        error = LAI_ERROR_OUT_OF_MEMORY;
+        goto out;
+    }
+    writer.data = data + sizeof(struct lai_snapshot_header);
+    writer.offset = 0;
+    if ((error = lai_snapshot_put_nsnodes(&writer)))
+        goto out;
+
+    header.magic = LAI_SNAPSHOT_MAGIC;
+    header.version = LAI_SNAPSHOT_VERSION;
+    header.payload_hash = lai_snapshot_hash(0xCBF29CE484222325, writer.data, writer.offset);
+    header.num_tables = tables.num_tables;
+    header.num_nodes = num_nodes;
+    memcpy(data, &header, sizeof(struct lai_snapshot_header));
+
+    *image = data;
+    *size = data_size;
+    data = NULL;
+
+out:
+    if (data)
+        laihost_free(data, data_size);
+    if (writer.node_ids)
+        laihost_free(writer.node_ids, instance->ns_size * sizeof(uint32_t));
+    lai_snapshot_free_buffer_owners(&writer.buffer_owners);
+    lai_snapshot_free_tables(&tables);
+    return error;
+}
+
+//---------------------------------------------------------------------------------------
+// Deserialization.
+//---------------------------------------------------------------------------------------
+
+// The payload hash was verified before parsing. Inconsistencies thus indicate images that
+// were produced by a buggy (or different) version of LAI.
+static const uint8_t *lai_snapshot_get(struct lai_snapshot_reader *reader, size_t size) {
+    if (size > reader->size - reader->offset)
+        lai_panic("namespace snapshot is truncated");
+    const uint8_t *p = reader->data + reader->offset;
+    reader->offset += size;
+    return p;
+}
+
+static uint8_t lai_snapshot_get_u8(struct lai_snapshot_reader *reader) {
+    return *lai_snapshot_get(reader, 1);
+}
+
+static uint32_t lai_snapshot_get_u32(struct lai_snapshot_reader *reader) {
+    uint32_t value;
+    memcpy(&value, lai_snapshot_get(reader, 4), 4);
+    return value;
+}
+
+static uint64_t lai_snapshot_get_u64(struct lai_snapshot_reader *reader) {
+    uint64_t value;
+    memcpy(&value, lai_snapshot_get(reader, 8), 8);
+    return value;
+}
+
+static lai_nsnode_t *lai_snapshot_get_node(struct lai_snapshot_reader *reader) {
+    uint32_t id = lai_snapshot_get_u32(reader);
+    if (id == LAI_SNAPSHOT_NONE)
+        return NULL;
+    if (id == LAI_SNAPSHOT_ROOT)
+        return reader->root_node;
+    if (id >= reader->num_nodes)
+        lai_panic("namespace snapshot refers to invalid node %u", id);
+    return reader->nodes[id];
+}
+
+static const uint8_t *lai_snapshot_get_aml(struct lai_snapshot_reader *reader,
+                                           struct lai_aml_segment **amls) {
+    uint32_t table_id = lai_snapshot_get_u32(reader);
+    uint32_t offset = lai_snapshot_get_u32(reader);
+    if (table_id >= reader->tables->num_tables
+        || offset > reader->tables->tables[table_id]->header.length)
+        lai_panic("namespace snapshot refers to invalid AML");
+    if (amls)
+        *amls = reader->segments[table_id];
+    return (const uint8_t *)reader->tables->tables[table_id] + offset;
+}
+
+static void lai_snapshot_get_var(struct lai_snapshot_reader *reader, lai_variable_t *var) {
+    int type = lai_snapshot_get_u8(reader);
+    switch (type) {
+        case 0:
+            break;
+        case LAI_INTEGER:
+            var->type = LAI_INTEGER;
+            var->integer = lai_snapshot_get_u64(reader);
+            break;
+        case LAI_STRING: {
+            size_t length = lai_snapshot_get_u64(reader);
+            const uint8_t *content = lai_snapshot_get(reader, length);
+            if (lai_create_string(var, length))
+                lai_panic("could not allocate memory for string");
+            memcpy(lai_exec_string_access(var), content, length);
+            break;
+        }
+        case LAI_BUFFER: {
+            size_t size = lai_snapshot_get_u64(reader);
+            const uint8_t *content = lai_snapshot_get(reader, size);
+            if (lai_create_buffer(var, size))
+                lai_panic("could not allocate memory for buffer");
+            memcpy(lai_exec_buffer_access(var), content, size);
+            break;
+        }
+        case LAI_PACKAGE: {
+            size_t size = lai_snapshot_get_u32(reader);
+            if (lai_create_pkg(var, size))
+                lai_panic("could not allocate memory for package");
+            for (size_t i = 0; i < size; i++)
+                lai_snapshot_get_var(reader, &var->pkg_ptr->elems[i]);
+            break;
+        }
+        case LAI_HANDLE:
+            var->type = LAI_HANDLE;
+            var->handle = lai_snapshot_get_node(reader);
+            break;
+        case LAI_LAZY_HANDLE: {
+            lai_nsnode_t *ctx_handle = lai_snapshot_get_node(reader);
+            const uint8_t *aml = lai_snapshot_get_aml(reader, NULL);
+            if (lai_exec_create_lazy_handle(var, ctx_handle, aml))
+                lai_panic("could not allocate memory for lazy handle");
+            break;
+        }
+        default:
+            lai_panic("namespace snapshot contains object of invalid type %d", type);
+    }
+}
+
+static void lai_snapshot_get_nsnode(struct lai_snapshot_reader *reader, lai_nsnode_t *node) {
+    memcpy(node->name, lai_snapshot_get(reader, 4), 4);
+    node->type = lai_snapshot_get_u8(reader);
+    node->parent = lai_snapshot_get_node(reader);
+
+    switch (node->type) {
+        case LAI_NAMESPACE_METHOD: {
+            int (*method_override)(lai_variable_t *, lai_variable_t *) = NULL;
+            switch (lai_snapshot_get_u8(reader)) {
+                case LAI_SNAPSHOT_METHOD_AML: {
+                    struct lai_aml_segment *amls;
+                    node->pointer = (void *)lai_snapshot_get_aml(reader, &amls);
+                    node->amls = amls;
+                    node->size = lai_snapshot_get_u32(reader);
+                    break;
+                }
+                case LAI_SNAPSHOT_METHOD_OSI:
+                    method_override = &lai_do_osi_method;
+                    break;
+                case LAI_SNAPSHOT_METHOD_OS:
+                    method_override = &lai_do_os_method;
+                    break;
+                case LAI_SNAPSHOT_METHOD_REV:
+                    method_override = &lai_do_rev_method;
+                    break;
+                default:
+                    lai_panic("namespace snapshot contains invalid method");
+            }
+            if (method_override)
+                lai_get_overrides(node)->method_override = method_override;
+            node->method_flags = lai_snapshot_get_u8(reader);
+            break;
+        }
+        case LAI_NAMESPACE_ALIAS:
+            node->al_target = lai_snapshot_get_node(reader);
+            break;
+        case LAI_NAMESPACE_FIELD:
+            node->fld_region_node = lai_snapshot_get_node(reader);
+            node->fld_offset = lai_snapshot_get_u64(reader);
+            node->fld_size = lai_snapshot_get_u32(reader);
+            node->fld_flags = lai_snapshot_get_u8(reader);
+            break;
+        case LAI_NAMESPACE_INDEXFIELD:
+            node->idxf = laihost_malloc(sizeof(struct lai_index_field));
+            if (!node->idxf)
+                lai_panic("could not allocate memory for IndexField");
+            node->idxf->index_node = lai_snapshot_get_node(reader);
+            node->idxf->data_node = lai_snapshot_get_node(reader);
+            node->idxf->offset = lai_snapshot_get_u64(reader);
+            node->idxf->flags = lai_snapshot_get_u8(reader);
+            node->idxf->size = lai_snapshot_get_u8(reader);
+            break;
+        case LAI_NAMESPACE_BANK_FIELD:
+            node->bkf = laihost_malloc(sizeof(struct lai_bank_field));
+            if (!node->bkf)
+                lai_panic("could not allocate memory for BankField");
+            node->bkf->region_node = lai_snapshot_get_node(reader);
+            node->bkf->bank_node = lai_snapshot_get_node(reader);
+            node->bkf->offset = lai_snapshot_get_u64(reader);
+            node->bkf->value = lai_snapshot_get_u64(reader);
+            node->bkf->flags = lai_snapshot_get_u8(reader);
+            node->bkf->size = lai_snapshot_get_u8(reader);
+            break;
+        case LAI_NAMESPACE_BUFFER_FIELD: {
+            lai_nsnode_t *owner = lai_snapshot_get_node(reader);
+            if (owner) {
+                if (owner->object.type != LAI_BUFFER)
+                    lai_panic("namespace snapshot contains invalid buffer field");
+                node->bf_buffer = owner->object.buffer_ptr;
+                lai_rc_ref(&node->bf_buffer->rc);
+            } else {
+                size_t size = lai_snapshot_get_u64(reader);
+                const uint8_t *content = lai_snapshot_get(reader, size);
+                LAI_CLEANUP_VAR lai_variable_t buffer = LAI_VAR_INITIALIZER;
+                if (lai_create_buffer(&buffer, size))
+                    lai_panic("could not allocate memory for buffer");
+                memcpy(lai_exec_buffer_access(&buffer), content, size);
+                node->bf_buffer = buffer.buffer_ptr;
+                lai_rc_ref(&node->bf_buffer->rc);
+            }
+            node->bf_offset = lai_snapshot_get_u64(reader);
+            node->bf_size = lai_snapshot_get_u64(reader);
+            break;
+        }
+        case LAI_NAMESPACE_PROCESSOR:
+            node->cpu_id = lai_snapshot_get_u8(reader);
+            node->pblk_addr = lai_snapshot_get_u32(reader);
+            node->pblk_len = lai_snapshot_get_u8(reader);
+            break;
+        case LAI_NAMESPACE_OPREGION:
+            node->op_base = lai_snapshot_get_u64(reader);
+            node->op_length = lai_snapshot_get_u64(reader);
+            node->op_address_space = lai_snapshot_get_u8(reader);
+            break;
+    }
+
+    lai_snapshot_get_var(reader, &node->object);
+}
+
+lai_api_error_t lai_load_namespace(const void *image, size_t size) {
+    if (!laihost_scan)
+        lai_panic("lai_load_namespace() needs table management functions");
+
+    struct lai_instance *instance = lai_current_instance();
+    if (instance->root_node)
+        return LAI_ERROR_ILLEGAL_ARGUMENTS;
+
+    lai_api_error_t error;
+    struct lai_snapshot_header header;
+    struct lai_snapshot_tables tables = {0};
+    struct lai_snapshot_reader reader = {0};
+    uint64_t key;
+
+    // Validate the image before modifying any state.
+    if (size < sizeof(struct lai_snapshot_header)) {
+        error = LAI_ERROR_UNEXPECTED_RESULT;
+        goto out;
+    }
+    memcpy(&header, image, sizeof(struct lai_snapshot_header));
+    reader.data = (const uint8_t *)image + sizeof(struct lai_snapshot_header);
+    reader.size = size - sizeof(struct lai_snapshot_header);
+    uint64_t payload_hash = lai_snapshot_hash(0xCBF29CE484222325, reader.data, reader.size);
+    if (header.magic != LAI_SNAPSHOT_MAGIC || header.version != LAI_SNAPSHOT_VERSION
+        || header.payload_hash != payload_hash) {
+        error = LAI_ERROR_UNEXPECTED_RESULT;
+        goto out;
+    }
+
+    if ((error = lai_snapshot_scan_tables(&tables, &key)))
+        goto out;
+    if (key != header.key || tables.num_tables != header.num_tables) {
+        // The firmware's tables changed. The caller should fall back to lai_create_namespace().
+        error = LAI_ERROR_UNEXPECTED_RESULT;
+        goto out;
+    }
+
+    instance->fadt = laihost_scan("FACP", 0);
+    if (!instance->fadt)
+        lai_panic("unable to find ACPI FADT.");
+
+    reader.tables = &tables;
+    reader.num_nodes = header.num_nodes;
+    reader.segments = laihost_malloc(tables.num_tables * sizeof(struct lai_aml_segment *));
+    reader.nodes = laihost_malloc(header.num_nodes * sizeof(lai_nsnode_t *));
+    if (!reader.segments || !reader.nodes)
+        lai_panic("could not allocate memory for namespace snapshot");
+    for (size_t i = 0; i < tables.num_tables; i++)
+        reader.segments[i] = lai_load_table(tables.tables[i], tables.indices[i]);
+
+    // Same as lai_create_root(); the remaining predefined objects are part of the image.
+    reader.root_node = lai_create_nsnode_or_die();
+    reader.root_node->type = LAI_NAMESPACE_ROOT;
+    lai_namecpy(reader.root_node->name, "\\___");
+    instance->root_node = reader.root_node;
+
+    // Allocate all nodes upfront, such that references can be resolved immediately.
+    for (uint32_t i = 0; i < header.num_nodes; i++)
+        reader.nodes[i] = lai_create_nsnode_or_die();
+    for (uint32_t i = 0; i < header.num_nodes; i++)
+        lai_snapshot_get_nsnode(&reader, reader.nodes[i]);
+    for (uint32_t i = 0; i < header.num_nodes; i++) {
+        lai_nsnode_t *node = lai_snapshot_get_node(&reader);
+        if (!node || node == reader.root_node)
+            lai_panic("namespace snapshot contains invalid node order");
+        lai_install_nsnode(node);
+    }
+    if (reader.offset != reader.size)
+        lai_panic("namespace snapshot contains trailing data");
+
+    lai_debug("ACPI namespace loaded from snapshot, total of %d predefined objects.",
+              instance->ns_size);
+
+out:
+    if (reader.nodes)
+        laihost_free(reader.nodes, header.num_nodes * sizeof(lai_nsnode_t *));
+    if (reader.segments)
+        laihost_free(reader.segments, tables.num_tables * sizeof(struct lai_aml_segment *));
+    lai_snapshot_free_tables(&tables);
+    return error;
+}
@@ -10,131 +10,146 @@
 
 #include <lai/internal-util.h>
 
-static void lai_hashtable_grow(struct lai_hashtable *ht, int n, int m) {
-    LAI_ENSURE(n >= ht->elem_capacity);
-    LAI_ENSURE(m >= ht->bucket_capacity);
-
-    void **new_elem_ptr_tab = laihost_malloc(n * sizeof(void *));
-    int *new_elem_hash_tab = laihost_malloc(n * sizeof(int));
-    int *new_bucket_tab = laihost_malloc(m * sizeof(int));
-    if (!new_elem_ptr_tab || !new_elem_hash_tab || !new_bucket_tab)
-        lai_panic("could not allocate memory for children table");
+#define LAI_HASHTABLE_TOMBSTONE 0xFFFFFFFF
+#define LAI_HASHTABLE_MIN_CAPACITY 4
+
+// Keys are usually NameSegs, i.e., four ASCII characters. Mix the bits such that
+// the low bits of the hash depend on all characters.
+static inline uint32_t lai_hashtable_hash(uint32_t key) {
+    uint32_t h = key * 0x9E3779B1;
+    return h ^ (h >> 16);
+}
 
-    memset(new_elem_ptr_tab, 0, n * sizeof(void *));
-    for (int i = 0; i < m; i++)
-        new_bucket_tab[i] = -1;
+static void lai_hashtable_rehash(struct lai_hashtable *ht, int n) {
+    LAI_ENSURE(n > ht->num_elems);
+    LAI_ENSURE(!(n & (n - 1)));
 
-    for (int k = 0; k < ht->elem_capacity; k++) {
-        if (!ht->elem_ptr_tab[k])
+    struct lai_hashtable_slot *new_slots = laihost_malloc(n * sizeof(struct lai_hashtable_slot));
+    if (!new_slots)
+        lai_panic("could not allocate memory for children table");
+    memset(new_slots, 0, n * sizeof(struct lai_hashtable_slot));
+
+    for (int k = 0; k < ht->capacity; k++) {
+        struct lai_hashtable_slot *slot = &ht->slots[k];
+        if (!slot->elem)
             continue;
-        new_elem_ptr_tab[k] = ht->elem_ptr_tab[k];
-        new_elem_hash_tab[k] = ht->elem_hash_tab[k];
-
-        for (int i = 0;; i++) {
-            LAI_ENSURE(i < m);
-            int b = (ht->elem_hash_tab[k] + i) & (m - 1);
-            if (new_bucket_tab[b] < 0) {
-                new_bucket_tab[b] = k;
+
+        for (uint32_t i = lai_hashtable_hash(slot->key);; i++) {
+            struct lai_hashtable_slot *new_slot = &new_slots[i & (n - 1)];
+            if (!new_slot->elem) {
+                *new_slot = *slot;
                 break;
             }
         }
     }
 
-    if (ht->elem_capacity) {
-        laihost_free(ht->elem_ptr_tab, ht->elem_capacity * sizeof(void *));
-        laihost_free(ht->elem_hash_tab, ht->elem_capacity * sizeof(int));
+    if (ht->capacity)
+        laihost_free(ht->slots, ht->capacity * sizeof(struct lai_hashtable_slot));
+
+    ht->slots = new_slots;
+    ht->capacity = n;
+    ht->num_tombstones = 0;
+}
+
+// Rehashes the table to the smallest capacity that keeps the load factor at or below 1/2.
+// This also removes all tombstones. Empty tables are freed.
+static inline void lai_hashtable_compact(struct lai_hashtable *ht) {
+    if (!ht->num_elems) {
+        // Drop the table entirely, it will be reallocated on the next insertion.
+        if (ht->capacity)
+            laihost_free(ht->slots, ht->capacity * sizeof(struct lai_hashtable_slot));
+        ht->slots = NULL;
+        ht->capacity = 0;
+        ht->num_tombstones = 0;
+        return;
     }
-    if (ht->bucket_capacity)
-        laihost_free(ht->bucket_tab, ht->bucket_capacity * sizeof(int));
-
-    ht->elem_ptr_tab = new_elem_ptr_tab;
-    ht->elem_hash_tab = new_elem_hash_tab;
-    ht->bucket_tab = new_bucket_tab;
-    ht->elem_capacity = n;
-    ht->bucket_capacity = m;
+
+    int n = LAI_HASHTABLE_MIN_CAPACITY;
+    while (2 * ht->num_elems > n)
+        n *= 2;
+    if (n == ht->capacity && !ht->num_tombstones)
+        return;
+    lai_hashtable_rehash(ht, n);
 }
 
-static inline void lai_hashtable_insert(struct lai_hashtable *ht, int h, void *elem) {
+// Inserts an element. The caller must ensure that the key is not already present.
+static inline void lai_hashtable_insert(struct lai_hashtable *ht, uint32_t key, void *elem) {
     LAI_ENSURE(elem);
-
-    if (!ht->elem_capacity || !ht->bucket_capacity) {
-        lai_hashtable_grow(ht, 2, 4);
-    } else if (ht->num_elems + 1 >= ht->elem_capacity) {
-        // TODO: We should grow more aggressively to avoid O(n) behavior
-        //       if the table is almost full.
-        int n = 2 * ht->elem_capacity;
-        int m = 2 * ht->bucket_capacity;
-        lai_hashtable_grow(ht, n, m);
+    LAI_ENSURE(key && key != LAI_HASHTABLE_TOMBSTONE);
+
+    // Keep the load factor (including tombstones) below 3/4 such that probe sequences
+    // stay short and always terminate at an empty slot.
+    if (4 * (ht->num_elems + ht->num_tombstones + 1) > 3 * ht->capacity) {
+        int n = ht->capacity ? ht->capacity : LAI_HASHTABLE_MIN_CAPACITY;
+        while (4 * (ht->num_elems + 1) > 3 * n)
+            n *= 2;
+        lai_hashtable_rehash(ht, n);
     }
 
-    // Find a free slot in the element table.
-    int k;
-    for (k = 0; k < ht->elem_capacity; k++)
-        if (!ht->elem_ptr_tab[k])
-            break;
-    LAI_ENSURE(k < ht->elem_capacity);
-
-    ht->elem_ptr_tab[k] = elem;
-    ht->elem_hash_tab[k] = h;
-    ht->num_elems++;
-
-    // Add an entry in the bucket table.
-    for (int i = 0;; i++) {
-        LAI_ENSURE(i < ht->bucket_capacity);
-        int b = (h + i) & (ht->bucket_capacity - 1);
-        if (ht->bucket_tab[b] < 0) {
-            ht->bucket_tab[b] = k;
-            break;
-        }
+    for (uint32_t i = lai_hashtable_hash(key);; i++) {
+        struct lai_hashtable_slot *slot = &ht->slots[i & (ht->capacity - 1)];
+        if (slot->elem)
+            continue;
+        if (slot->key == LAI_HASHTABLE_TOMBSTONE)
+            ht->num_tombstones--;
+        slot->key = key;
+        slot->elem = elem;
+        ht->num_elems++;
+        return;
     }
 }
 
-struct lai_hashtable_chain {
-    int i;
-};
-
-#define LAI_HASHTABLE_CHAIN_INITIALIZER                                                            \
-    { .i = -1 }
-
-// TODO: When searching for a non-existing hash, we alreadys walk through the entire table.
-//       Improve the algorithm to avoid this.
-static inline int lai_hashtable_chain_advance(struct lai_hashtable *ht, int h,
-                                              struct lai_hashtable_chain *chain) {
-    LAI_ENSURE(chain->i < ht->bucket_capacity);
-    for (;;) {
-        chain->i++;
-        LAI_ENSURE(chain->i >= 0);
-        if (chain->i == ht->bucket_capacity)
-            return 1;
-        int b = (h + chain->i) & (ht->bucket_capacity - 1);
-        int k = ht->bucket_tab[b];
-        if (k >= 0 && ht->elem_hash_tab[k] == h)
-            return 0;
+// Returns the slot that stores the given key or NULL if the key is not present.
+static inline struct lai_hashtable_slot *lai_hashtable_find_slot(struct lai_hashtable *ht,
+                                                                 uint32_t key) {
+    if (!ht->num_elems)
+        return NULL;
+
+    for (uint32_t i = lai_hashtable_hash(key);; i++) {
+        struct lai_hashtable_slot *slot = &ht->slots[i & (ht->capacity - 1)];
+        if (slot->key == key)
+            return slot->elem ? slot : NULL;
+        if (!slot->key)
+            return NULL; // Empty slots terminate the probe sequence.
     }
 }
 
-static inline void *lai_hashtable_chain_get(struct lai_hashtable *ht, int h,
-                                            struct lai_hashtable_chain *chain) {
-    LAI_ENSURE(chain->i >= 0);
-    LAI_ENSURE(chain->i < ht->bucket_capacity);
-
-    int b = (h + chain->i) & (ht->bucket_capacity - 1);
-    int k = ht->bucket_tab[b];
-    LAI_ENSURE(k >= 0);
-    void *elem = ht->elem_ptr_tab[k];
-    LAI_ENSURE(elem);
-    return elem;
+static inline void *lai_hashtable_find(struct lai_hashtable *ht, uint32_t key) {
+    struct lai_hashtable_slot *slot = lai_hashtable_find_slot(ht, key);
+    if (!slot)
+        return NULL;
+    return slot->elem;
 }
 
-static inline void lai_hashtable_chain_remove(struct lai_hashtable *ht, int h,
-                                              struct lai_hashtable_chain *chain) {
-    LAI_ENSURE(chain->i >= 0);
-    LAI_ENSURE(chain->i < ht->bucket_capacity);
+// Removes an element and returns it (or NULL if the key is not present).
+static inline void *lai_hashtable_remove(struct lai_hashtable *ht, uint32_t key) {
+    struct lai_hashtable_slot *slot = lai_hashtable_find_slot(ht, key);
+    if (!slot)
+        return NULL;
 
-    int b = (h + chain->i) & (ht->bucket_capacity - 1);
-    int k = ht->bucket_tab[b];
-    LAI_ENSURE(k >= 0);
-    ht->elem_ptr_tab[k] = NULL;
-    ht->bucket_tab[b] = -1;
+    void *elem = slot->elem;
     ht->num_elems--;
+
+    // If the next slot is empty, no probe sequence passes through this slot
+    // and we do not need a tombstone.
+    int k = slot - ht->slots;
+    if (!ht->slots[(k + 1) & (ht->capacity - 1)].key) {
+        slot->key = 0;
+    } else {
+        slot->key = LAI_HASHTABLE_TOMBSTONE;
+        ht->num_tombstones++;
+    }
+    slot->elem = NULL;
+
+    // Shrink once the table is less than 1/8 full. As we grow at 3/4 and shrink
+    // to a load factor of 1/2 at most, alternating insertions and removals cannot
+    // trigger repeated rehashing. Tables that become empty are freed.
+    if (!ht->num_elems || (ht->capacity > LAI_HASHTABLE_MIN_CAPACITY
+                           && 8 * ht->num_elems < ht->capacity)) {
+        lai_hashtable_compact(ht);
+    } else if (4 * ht->num_tombstones > ht->capacity) {
+        // Too many tombstones make misses slow; purge them.
+        lai_hashtable_rehash(ht, ht->capacity);
+    }
+    return elem;
 }
@@ -7,35 +7,88 @@
 
 #include "exec_impl.h"
 #include "libc.h"
+#include "slab.h"
 
-// laihost_free_package(): Frees a package object and all its children
-static void laihost_free_package(lai_variable_t *object) {
-    for (size_t i = 0; i < object->pkg_ptr->size; i++)
-        lai_var_finalize(&object->pkg_ptr->elems[i]);
-    laihost_free(object->pkg_ptr->elems, object->pkg_ptr->size * sizeof(lai_variable_t));
-    laihost_free(object->pkg_ptr, sizeof(struct lai_pkg_head));
+_Static_assert(sizeof(lai_variable_t) == 16, "lai_variable_t is not 16 bytes");
+
+static void lai_exec_unref_pkg_block(struct lai_pkg_block *block) {
+    if (lai_rc_unref(&block->rc))
+        laihost_free(block, block->size);
+}
+
+void lai_exec_release_pkg_elems(struct lai_pkg_head *head) {
+    if (head->elems_block)
+        lai_exec_unref_pkg_block(head->elems_block);
+    else
+        laihost_free(head->elems, head->capacity * sizeof(lai_variable_t));
+    head->elems_block = NULL;
+}
+
+// laihost_free_package(): Frees the elements of a package object and all its children
+static void laihost_free_package(struct lai_pkg_head *head) {
+    for (size_t i = 0; i < head->size; i++)
+        lai_var_finalize(&head->elems[i]);
+    lai_exec_release_pkg_elems(head);
+}
+
+void lai_exec_unref_string(struct lai_string_head *head) {
+    if (!lai_rc_unref(&head->rc))
+        return;
+    if (head->shared)
+        lai_exec_unref_string(head->shared);
+    else if (head->in_arena)
+        lai_exec_arena_free(head->content);
+    else if (head->content != head->inline_content)
+        laihost_free(head->content, head->capacity);
+    lai_slab_free(LAI_SLAB_STRING_HEAD, head);
+}
+
+void lai_exec_unref_buffer(struct lai_buffer_head *head) {
+    if (!lai_rc_unref(&head->rc))
+        return;
+    if (head->shared)
+        lai_exec_unref_buffer(head->shared);
+    else if (head->in_arena)
+        lai_exec_arena_free(head->content);
+    else if (head->content != head->inline_content)
+        laihost_free(head->content, head->size);
+    lai_slab_free(LAI_SLAB_BUFFER_HEAD, head);
+}
+
+void lai_exec_unref_pkg(struct lai_pkg_head *head) {
+    if (!lai_rc_unref(&head->rc))
+        return;
+    if (head->shared)
+        lai_exec_unref_pkg(head->shared);
+    else
+        laihost_free_package(head);
+    if (head->block)
+        lai_exec_unref_pkg_block(head->block);
+    else
+        lai_slab_free(LAI_SLAB_PKG_HEAD, head);
+}
+
+static void lai_exec_unref_lazy_handle(struct lai_lazy_handle *head) {
+    if (lai_rc_unref(&head->rc))
+        lai_slab_free(LAI_SLAB_LAZY_HANDLE, head);
 }
 
 void lai_var_finalize(lai_variable_t *object) {
     switch (object->type) {
         case LAI_STRING:
         case LAI_STRING_INDEX:
-            if (lai_rc_unref(&object->string_ptr->rc)) {
-                laihost_free(object->string_ptr->content, object->string_ptr->capacity);
-                laihost_free(object->string_ptr, sizeof(struct lai_string_head));
-            }
+            lai_exec_unref_string(object->string_ptr);
             break;
         case LAI_BUFFER:
         case LAI_BUFFER_INDEX:
-            if (lai_rc_unref(&object->buffer_ptr->rc)) {
-                laihost_free(object->buffer_ptr->content, object->buffer_ptr->size);
-                laihost_free(object->buffer_ptr, sizeof(struct lai_buffer_head));
-            }
+            lai_exec_unref_buffer(object->buffer_ptr);
             break;
         case LAI_PACKAGE:
         case LAI_PACKAGE_INDEX:
-            if (lai_rc_unref(&object->pkg_ptr->rc))
-                laihost_free_package(object);
+            lai_exec_unref_pkg(object->pkg_ptr);
+            break;
+        case LAI_LAZY_HANDLE:
+            lai_exec_unref_lazy_handle(object->lazy_ptr);
             break;
     }
 
@@ -74,6 +127,9 @@ void lai_var_assign(lai_variable_t *dest, lai_variable_t *src) {
         case LAI_PACKAGE_INDEX:
             lai_rc_ref(&src->pkg_ptr->rc);
             break;
+        case LAI_LAZY_HANDLE:
+            lai_rc_ref(&src->lazy_ptr->rc);
+            break;
     }
 
     lai_var_move(dest, &temp);
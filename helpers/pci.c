@@ -31,8 +31,7 @@ int lai_pci_route(acpi_resource_t *dest, uint16_t seg, uint8_t bus, uint8_t slot
 
 lai_api_error_t lai_pci_route_pin(acpi_resource_t *dest, uint16_t seg, uint8_t bus, uint8_t slot,
                                   uint8_t function, uint8_t pin) {
-    LAI_CLEANUP_STATE lai_state_t state;
-    lai_init_state(&state);
+    LAI_CLEANUP_ACQUIRED_STATE lai_state_t *state = lai_acquire_state();
 
     LAI_ENSURE(pin && pin <= 4);
 
@@ -41,7 +40,7 @@ lai_api_error_t lai_pci_route_pin(acpi_resource_t *dest, uint16_t seg, uint8_t b
     pin--;
 
     // find the PCI bus in the namespace
-    lai_nsnode_t *handle = lai_pci_find_bus(seg, bus, &state);
+    lai_nsnode_t *handle = lai_pci_find_bus(seg, bus, state);
     if (!handle)
         return LAI_ERROR_NO_SUCH_NODE;
 
@@ -54,7 +53,7 @@ lai_api_error_t lai_pci_route_pin(acpi_resource_t *dest, uint16_t seg, uint8_t b
 
     LAI_CLEANUP_VAR lai_variable_t prt = LAI_VAR_INITIALIZER;
 
-    if (lai_eval(&prt, prt_handle, &state)) {
+    if (lai_eval(&prt, prt_handle, state)) {
         lai_warn("failed to evaluate _PRT");
         return LAI_ERROR_EXECUTION_FAILURE;
     }
@@ -77,28 +76,22 @@ lai_api_error_t lai_pci_route_pin(acpi_resource_t *dest, uint16_t seg, uint8_t b
 }
 
 lai_api_error_t lai_pci_parse_prt(struct lai_prt_iterator *iter) {
-    LAI_CLEANUP_VAR lai_variable_t prt_entry = LAI_VAR_INITIALIZER;
-    LAI_CLEANUP_VAR lai_variable_t prt_entry_addr = LAI_VAR_INITIALIZER;
-    LAI_CLEANUP_VAR lai_variable_t prt_entry_pin = LAI_VAR_INITIALIZER;
-    LAI_CLEANUP_VAR lai_variable_t prt_entry_type = LAI_VAR_INITIALIZER;
-    LAI_CLEANUP_VAR lai_variable_t prt_entry_index = LAI_VAR_INITIALIZER;
+    // The _PRT is only read; views avoid copying the entries.
+    struct lai_pkg_view prt;
+    struct lai_pkg_view prt_entry;
 
-    if (lai_obj_get_pkg(iter->prt, iter->i, &prt_entry))
+    if (lai_obj_view_pkg(iter->prt, &prt))
+        return LAI_ERROR_UNEXPECTED_RESULT;
+    if (lai_pkg_view_get_pkg(&prt, iter->i, &prt_entry))
         return LAI_ERROR_UNEXPECTED_RESULT;
 
     iter->i++;
 
-    if (lai_obj_get_pkg(&prt_entry, 0, &prt_entry_addr))
-        return LAI_ERROR_UNEXPECTED_RESULT;
-    if (lai_obj_get_pkg(&prt_entry, 1, &prt_entry_pin))
-        return LAI_ERROR_UNEXPECTED_RESULT;
-    if (lai_obj_get_pkg(&prt_entry, 2, &prt_entry_type))
-        return LAI_ERROR_UNEXPECTED_RESULT;
-    if (lai_obj_get_pkg(&prt_entry, 3, &prt_entry_index))
+    if (prt_entry.size < 4)
         return LAI_ERROR_UNEXPECTED_RESULT;
 
     uint64_t addr;
-    if (lai_obj_get_integer(&prt_entry_addr, &addr))
+    if (lai_pkg_view_get_integer(&prt_entry, 0, &addr))
         return LAI_ERROR_UNEXPECTED_RESULT;
 
     iter->slot = (addr >> 16) & 0xFFFF;
@@ -108,15 +101,15 @@ lai_api_error_t lai_pci_parse_prt(struct lai_prt_iterator *iter) {
         iter->function = -1;
 
     uint64_t pin;
-    if (lai_obj_get_integer(&prt_entry_pin, &pin))
+    if (lai_pkg_view_get_integer(&prt_entry, 1, &pin))
         return LAI_ERROR_UNEXPECTED_RESULT;
 
     iter->pin = pin;
 
-    enum lai_object_type type = lai_obj_get_type(&prt_entry_type);
+    enum lai_object_type type = lai_pkg_view_get_type(&prt_entry, 2);
     if (type == LAI_TYPE_INTEGER) { // direct routing to GSI
         uint64_t gsi;
-        if (lai_obj_get_integer(&prt_entry_index, &gsi))
+        if (lai_pkg_view_get_integer(&prt_entry, 3, &gsi))
             return LAI_ERROR_UNEXPECTED_RESULT;
 
         // TODO: Look up the GSI in the _CRS of the host bridge.
@@ -129,21 +122,20 @@ lai_api_error_t lai_pci_parse_prt(struct lai_prt_iterator *iter) {
     } else if (type == LAI_TYPE_DEVICE) { // GSI obtained via a link dev
         lai_nsnode_t *link_handle;
         uint64_t res_index;
-        if (lai_obj_get_handle(&prt_entry_type, &link_handle))
+        if (lai_pkg_view_get_handle(&prt_entry, 2, &link_handle))
             return LAI_ERROR_UNEXPECTED_RESULT;
-        if (lai_obj_get_integer(&prt_entry_index, &res_index))
+        if (lai_pkg_view_get_integer(&prt_entry, 3, &res_index))
             return LAI_ERROR_UNEXPECTED_RESULT;
 
         // Get _CRS of the link device.
-        LAI_CLEANUP_STATE lai_state_t state;
-        lai_init_state(&state);
+        LAI_CLEANUP_ACQUIRED_STATE lai_state_t *state = lai_acquire_state();
 
         lai_nsnode_t *crs_handle = lai_resolve_path(link_handle, "_CRS");
         if (!crs_handle)
             return LAI_ERROR_UNEXPECTED_RESULT;
 
         LAI_CLEANUP_VAR lai_variable_t crs_buffer = LAI_VAR_INITIALIZER;
-        int status = lai_eval(&crs_buffer, crs_handle, &state);
+        int status = lai_eval(&crs_buffer, crs_handle, state);
         if (status)
             return LAI_ERROR_EXECUTION_FAILURE;
 
@@ -168,7 +160,7 @@ lai_api_error_t lai_pci_parse_prt(struct lai_prt_iterator *iter) {
         }
         return LAI_ERROR_UNEXPECTED_RESULT;
     } else {
-        lai_warn("PRT entry has unexpected type %d", prt_entry_type);
+        lai_warn("PRT entry has unexpected type %d", type);
         return LAI_ERROR_TYPE_MISMATCH;
     }
 }
@@ -22,9 +22,6 @@ lai_api_error_t lai_enter_sleep(uint8_t sleep_state) {
 
     struct lai_instance *instance = lai_current_instance();
 
-    LAI_CLEANUP_STATE lai_state_t state;
-    lai_init_state(&state);
-
     const char *sleep_object;
     switch (sleep_state) {
         case 0:
@@ -57,15 +54,25 @@ lai_api_error_t lai_enter_sleep(uint8_t sleep_state) {
     }
 
     LAI_CLEANUP_VAR lai_variable_t package = LAI_VAR_INITIALIZER;
-    LAI_CLEANUP_VAR lai_variable_t slp_typa = LAI_VAR_INITIALIZER;
-    LAI_CLEANUP_VAR lai_variable_t slp_typb = LAI_VAR_INITIALIZER;
     int eval_status;
-    eval_status = lai_eval(&package, handle, &state);
+    {
+        LAI_CLEANUP_ACQUIRED_STATE lai_state_t *state = lai_acquire_state();
+        eval_status = lai_eval(&package, handle, state);
+    }
     if (eval_status) {
         lai_debug("sleep state S%d is not supported.", sleep_state);
         return LAI_ERROR_UNSUPPORTED;
     }
 
+    uint64_t slp_typa, slp_typb;
+    struct lai_pkg_view package_view;
+    if (lai_obj_view_pkg(&package, &package_view)
+        || lai_pkg_view_get_integer(&package_view, 0, &slp_typa)
+        || lai_pkg_view_get_integer(&package_view, 1, &slp_typb)) {
+        lai_warn("\\_S%d is not a package of SLP_TYPa and SLP_TYPb", sleep_state);
+        return LAI_ERROR_UNEXPECTED_RESULT;
+    }
+
     lai_debug("entering sleep state S%d...", sleep_state);
 
     // ACPI spec says we should call _PTS() and _GTS() before actually sleeping
@@ -73,7 +80,7 @@ lai_api_error_t lai_enter_sleep(uint8_t sleep_state) {
     handle = lai_resolve_path(NULL, "\\_PTS");
 
     if (handle) {
-        lai_init_state(&state);
+        LAI_CLEANUP_ACQUIRED_STATE lai_state_t *state = lai_acquire_state();
 
         // pass the sleeping type as an argument
         LAI_CLEANUP_VAR lai_variable_t sleep_object = LAI_VAR_INITIALIZER;
@@ -81,8 +88,7 @@ lai_api_error_t lai_enter_sleep(uint8_t sleep_state) {
         sleep_object.integer = sleep_state & 0xFF;
 
         lai_debug("execute _PTS(%d)", sleep_state);
-        lai_eval_largs(NULL, handle, &state, &sleep_object, NULL);
-        lai_finalize_state(&state);
+        lai_eval_largs(NULL, handle, state, &sleep_object, NULL);
     }
 
     // _GTS has actually become obsolete with ACPI 5.0A but we still execute it for compatibility
@@ -90,7 +96,7 @@ lai_api_error_t lai_enter_sleep(uint8_t sleep_state) {
     handle = lai_resolve_path(NULL, "\\_GTS");
 
     if (handle) {
-        lai_init_state(&state);
+        LAI_CLEANUP_ACQUIRED_STATE lai_state_t *state = lai_acquire_state();
 
         // pass the sleeping type as an argument
         LAI_CLEANUP_VAR lai_variable_t sleep_object = LAI_VAR_INITIALIZER;
@@ -98,24 +104,20 @@ lai_api_error_t lai_enter_sleep(uint8_t sleep_state) {
         sleep_object.integer = sleep_state & 0xFF;
 
         lai_debug("execute _GTS(%d)", sleep_state);
-        lai_eval_largs(NULL, handle, &state, &sleep_object, NULL);
-        lai_finalize_state(&state);
+        lai_eval_largs(NULL, handle, state, &sleep_object, NULL);
     }
 
-    lai_obj_get_pkg(&package, 0, &slp_typa);
-    lai_obj_get_pkg(&package, 1, &slp_typb);
-
     // and go to sleep
     uint16_t data;
     data = laihost_inw(instance->fadt->pm1a_control_block);
     data &= 0xE3FF;
-    data |= (slp_typa.integer << 10) | ACPI_SLEEP;
+    data |= (slp_typa << 10) | ACPI_SLEEP;
     laihost_outw(instance->fadt->pm1a_control_block, data);
 
     if (instance->fadt->pm1b_control_block) {
         data = laihost_inw(instance->fadt->pm1b_control_block);
         data &= 0xE3FF;
-        data |= (slp_typb.integer << 10) | ACPI_SLEEP;
+        data |= (slp_typb << 10) | ACPI_SLEEP;
         laihost_outw(instance->fadt->pm1b_control_block, data);
     }
 
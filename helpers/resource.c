@@ -27,31 +27,35 @@
 
 // read a device's resource info
 size_t lai_read_resource(lai_nsnode_t *device, acpi_resource_t *dest) {
-    LAI_CLEANUP_STATE lai_state_t state;
-    lai_init_state(&state);
+    LAI_CLEANUP_ACQUIRED_STATE lai_state_t *state = lai_acquire_state();
 
     lai_nsnode_t *crs_handle = lai_resolve_path(device, "_CRS");
     if (!crs_handle)
         return 0;
 
     LAI_CLEANUP_VAR lai_variable_t buffer = LAI_VAR_INITIALIZER;
-    int status = lai_eval(&buffer, crs_handle, &state);
+    int status = lai_eval(&buffer, crs_handle, state);
     if (status)
         return 0;
 
     // read the resource buffer
+    struct lai_buffer_view crs;
+    if (lai_obj_view_buffer(&buffer, &crs))
+        return 0;
+
     size_t count = 0;
-    uint8_t *data = lai_exec_buffer_access(&buffer);
+    const uint8_t *data = crs.data;
+    const uint8_t *end = crs.data + crs.size;
     size_t data_size;
 
-    acpi_small_irq_t *small_irq;
+    const acpi_small_irq_t *small_irq;
     uint16_t small_irq_mask;
 
-    acpi_large_irq_t *large_irq;
+    const acpi_large_irq_t *large_irq;
 
     size_t i;
 
-    while (data[0] != 0x79) {
+    while (data < end && data[0] != 0x79) {
         if (!(data[0] & 0x80)) {
             // small resource descriptor
             data_size = (size_t)data[0] & 7;
@@ -61,7 +65,7 @@ size_t lai_read_resource(lai_nsnode_t *device, acpi_resource_t *dest) {
                     return count;
 
                 case ACPI_SMALL_IRQ:
-                    small_irq = (acpi_small_irq_t *)&data[0];
+                    small_irq = (const acpi_small_irq_t *)&data[0];
                     small_irq_mask = small_irq->irq_mask;
 
                     i = 0;
@@ -100,7 +104,7 @@ size_t lai_read_resource(lai_nsnode_t *device, acpi_resource_t *dest) {
 
             switch (data[0]) {
                 case ACPI_LARGE_IRQ:
-                    large_irq = (acpi_large_irq_t *)&data[0];
+                    large_irq = (const acpi_large_irq_t *)&data[0];
 
                     dest[count].type = ACPI_RESOURCE_IRQ;
                     dest[count].base = (uint64_t)large_irq->irq;
@@ -54,7 +54,6 @@ void lai_set_sci_event(uint16_t value) {
 
 int lai_enable_acpi(uint32_t mode) {
     lai_nsnode_t *handle;
-    lai_state_t state;
     lai_debug("attempt to enable ACPI...");
 
     struct lai_instance *instance = lai_current_instance();
@@ -67,10 +66,9 @@ int lai_enable_acpi(uint32_t mode) {
     /* first run \._SB_._INI */
     handle = lai_resolve_path(NULL, "\\_SB_._INI");
     if (handle) {
-        lai_init_state(&state);
-        if (!lai_eval(NULL, handle, &state))
+        LAI_CLEANUP_ACQUIRED_STATE lai_state_t *state = lai_acquire_state();
+        if (!lai_eval(NULL, handle, state))
             lai_debug("evaluated \\_SB_._INI");
-        lai_finalize_state(&state);
     }
 
     /* _STA/_INI for all devices */
@@ -80,15 +78,14 @@ int lai_enable_acpi(uint32_t mode) {
     /* tell the firmware about the IRQ mode */
     handle = lai_resolve_path(NULL, "\\_PIC");
     if (handle) {
-        lai_init_state(&state);
+        LAI_CLEANUP_ACQUIRED_STATE lai_state_t *state = lai_acquire_state();
 
         LAI_CLEANUP_VAR lai_variable_t mode_object = LAI_VAR_INITIALIZER;
         mode_object.type = LAI_INTEGER;
         mode_object.integer = mode;
 
-        if (!lai_eval_largs(NULL, handle, &state, &mode_object, NULL))
+        if (!lai_eval_largs(NULL, handle, state, &mode_object, NULL))
             lai_debug("evaluated \\._PIC(%d)", mode);
-        lai_finalize_state(&state);
     }
 
     /* enable ACPI SCI */
@@ -146,11 +143,10 @@ int lai_evaluate_sta(lai_nsnode_t *node) {
 
     lai_nsnode_t *handle = lai_resolve_path(node, "_STA");
     if (handle) {
-        LAI_CLEANUP_STATE lai_state_t state;
-        lai_init_state(&state);
+        LAI_CLEANUP_ACQUIRED_STATE lai_state_t *state = lai_acquire_state();
 
         LAI_CLEANUP_VAR lai_variable_t result = LAI_VAR_INITIALIZER;
-        if (lai_eval(&result, handle, &state))
+        if (lai_eval(&result, handle, state))
             lai_panic("could not evaluate _STA");
         if (lai_obj_get_integer(&result, &sta))
             lai_panic("_STA returned non-integer object");
@@ -174,13 +170,11 @@ void lai_init_children(lai_nsnode_t *parent) {
                 handle = lai_resolve_path(node, "_INI");
 
                 if (handle) {
-                    lai_state_t state;
-                    lai_init_state(&state);
-                    if (!lai_eval(NULL, handle, &state)) {
+                    LAI_CLEANUP_ACQUIRED_STATE lai_state_t *state = lai_acquire_state();
+                    if (!lai_eval(NULL, handle, state)) {
                         LAI_CLEANUP_FREE_STRING char *fullpath = lai_stringify_node_path(handle);
                         lai_debug("evaluated %s", fullpath);
                     }
-                    lai_finalize_state(&state);
                 }
             }
 
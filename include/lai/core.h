@@ -26,6 +26,9 @@ extern "C" {
 
 #define ACPI_MAX_RESOURCES 512
 
+#define LAI_STATE_POOL_SIZE 16
+#define LAI_STATE_POOL_WAYS 2 // Number of cached states per CPU.
+
 // Convert a lai_api_error_t to a human readable string
 const char *lai_api_error_to_string(lai_api_error_t);
 
@@ -33,13 +36,32 @@ struct lai_instance {
     lai_nsnode_t *root_node;
 
     lai_nsnode_t **ns_array;
-    size_t ns_size;
+    size_t ns_size; // Number of used slots in ns_array (including free slots).
     size_t ns_capacity;
 
+    // Free slots of ns_array; these are reused before ns_array grows.
+    size_t *ns_free_slots;
+    size_t ns_num_free;
+    size_t ns_free_capacity;
+
+    // Incremented whenever a node is installed or uninstalled.
+    uint64_t ns_generation;
+    // Incremented whenever a Device() or a _HID or _CID object is installed or uninstalled.
+    uint64_t device_generation;
+    // Cache of lai_resolve_path() results; allocated on first use.
+    struct lai_resolve_cache_entry *resolve_cache;
+    // Index of devices by _HID and _CID; built on first use.
+    struct lai_device_index *device_index;
+
+    // Cache of cleared interpreter states, see lai_acquire_state().
+    lai_state_t *state_pool[LAI_STATE_POOL_SIZE];
+
     int acpi_revision;
     int trace;
 
     acpi_fadt_t *fadt;
+
+    struct lai_slab_cache slab_caches[LAI_SLAB_NUM_CACHES];
 };
 
 struct lai_instance *lai_current_instance();
@@ -49,19 +71,31 @@ void lai_finalize_state(lai_state_t *);
 
 #define LAI_CLEANUP_STATE __attribute__((cleanup(lai_finalize_state)))
 
+// Like lai_init_state()/lai_finalize_state() but states are recycled: acquiring a state
+// from the pool neither allocates nor clears memory, and stacks keep their grown capacity.
+lai_state_t *lai_acquire_state(void);
+void lai_release_state(lai_state_t *);
+
+static inline void lai_cleanup_acquired_state(lai_state_t **state) {
+    lai_release_state(*state);
+}
+
+#define LAI_CLEANUP_ACQUIRED_STATE __attribute__((cleanup(lai_cleanup_acquired_state)))
+
 struct lai_ns_iterator {
     size_t i;
 };
 
 struct lai_ns_child_iterator {
-    size_t i;
+    size_t i; // Non-zero once the iteration has started.
     lai_nsnode_t *parent;
+    lai_nsnode_t *next;
 };
 
 #define LAI_NS_ITERATOR_INITIALIZER                                                                \
     { 0 }
 #define LAI_NS_CHILD_ITERATOR_INITIALIZER(x)                                                       \
-    { 0, x }
+    { 0, x, NULL }
 
 static inline void lai_initialize_ns_iterator(struct lai_ns_iterator *iter) {
     *iter = (struct lai_ns_iterator)LAI_NS_ITERATOR_INITIALIZER;
@@ -81,13 +115,25 @@ void lai_create_namespace(void);
 char *lai_stringify_node_path(lai_nsnode_t *);
 lai_nsnode_t *lai_resolve_path(lai_nsnode_t *, const char *);
 lai_nsnode_t *lai_resolve_search(lai_nsnode_t *, const char *);
+// Returns the n-th device in definition order, or NULL.
 lai_nsnode_t *lai_get_device(size_t);
 int lai_check_device_pnp_id(lai_nsnode_t *, lai_variable_t *, lai_state_t *);
+// Returns the n-th device whose _HID or _CID matches the given ID, or NULL.
+// The ID can be an EISA ID such as "PNP0A03" or any other string ID.
 lai_nsnode_t *lai_enum(char *, size_t);
 void lai_eisaid(lai_variable_t *, const char *);
+// Evaluating objects while iterating is fine: nodes that are uninstalled meanwhile are
+// skipped, and nodes that already were visited are never moved to a later index.
 lai_nsnode_t *lai_ns_iterate(struct lai_ns_iterator *);
 lai_nsnode_t *lai_ns_child_iterate(struct lai_ns_child_iterator *);
 
+// Namespace snapshots, see core/snapshot.c.
+// lai_save_namespace() returns an image allocated by laihost_malloc().
+// lai_load_namespace() can be called instead of lai_create_namespace(); it returns
+// LAI_ERROR_UNEXPECTED_RESULT if the image does not match the firmware's AML tables.
+lai_api_error_t lai_save_namespace(void **image, size_t *size);
+lai_api_error_t lai_load_namespace(const void *image, size_t size);
+
 // Namespace functions.
 
 lai_nsnode_t *lai_ns_get_root();
@@ -124,6 +170,31 @@ lai_api_error_t lai_obj_get_integer(lai_variable_t *, uint64_t *);
 lai_api_error_t lai_obj_get_pkg(lai_variable_t *, size_t, lai_variable_t *);
 lai_api_error_t lai_obj_get_handle(lai_variable_t *, lai_nsnode_t **);
 
+// Views of packages and buffers, for code that only reads them.
+// Views do not take references; they are valid as long as the object that they were created
+// from (or the package that contains it) is alive and is not mutated. Reading through a view
+// does not allocate memory and does not touch reference counts.
+
+struct lai_pkg_view {
+    lai_variable_t *elems;
+    size_t size;
+};
+
+struct lai_buffer_view {
+    const uint8_t *data;
+    size_t size;
+};
+
+lai_api_error_t lai_obj_view_pkg(lai_variable_t *, struct lai_pkg_view *);
+lai_api_error_t lai_obj_view_buffer(lai_variable_t *, struct lai_buffer_view *);
+
+enum lai_object_type lai_pkg_view_get_type(struct lai_pkg_view *, size_t);
+lai_api_error_t lai_pkg_view_get_integer(struct lai_pkg_view *, size_t, uint64_t *);
+lai_api_error_t lai_pkg_view_get_string(struct lai_pkg_view *, size_t, const char **);
+lai_api_error_t lai_pkg_view_get_buffer(struct lai_pkg_view *, size_t, struct lai_buffer_view *);
+lai_api_error_t lai_pkg_view_get_pkg(struct lai_pkg_view *, size_t, struct lai_pkg_view *);
+lai_api_error_t lai_pkg_view_get_handle(struct lai_pkg_view *, size_t, lai_nsnode_t **);
+
 lai_api_error_t lai_obj_resize_string(lai_variable_t *, size_t);
 lai_api_error_t lai_obj_resize_buffer(lai_variable_t *, size_t);
 lai_api_error_t lai_obj_resize_pkg(lai_variable_t *, size_t);
@@ -165,6 +236,10 @@ void lai_var_assign(lai_variable_t *, lai_variable_t *);
 
 lai_api_error_t lai_eval_args(lai_variable_t *, lai_nsnode_t *, lai_state_t *, int,
                               lai_variable_t *);
+// Like lai_eval_args(), but takes ownership of the arguments: they are moved into the method
+// invocation (instead of being copied) and reset, even if the evaluation fails.
+lai_api_error_t lai_eval_move_args(lai_variable_t *, lai_nsnode_t *, lai_state_t *, int,
+                                   lai_variable_t *);
 lai_api_error_t lai_eval_largs(lai_variable_t *, lai_nsnode_t *, lai_state_t *, ...);
 lai_api_error_t lai_eval_vargs(lai_variable_t *, lai_nsnode_t *, lai_state_t *, va_list);
 lai_api_error_t lai_eval(lai_variable_t *, lai_nsnode_t *, lai_state_t *);
@@ -175,6 +250,13 @@ lai_api_error_t lai_populate(lai_nsnode_t *, struct lai_aml_segment *, lai_state
 // LAI initialization functions
 void lai_set_acpi_revision(int);
 
+// LAI memory management functions.
+
+// Retrieves statistics of one of LAI's internal object caches.
+lai_api_error_t lai_slab_get_stats(enum lai_slab_cache_id, struct lai_slab_stats *);
+// Returns memory of caches that have no objects in use to the host.
+void lai_slab_trim(void);
+
 // LAI debugging functions.
 
 #define LAI_TRACE_OP 1
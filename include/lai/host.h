@@ -69,6 +69,9 @@ __attribute__((weak)) void laihost_sync_wake(struct lai_sync_state *);
 
 __attribute__((weak)) void laihost_handle_amldebug(lai_variable_t *);
 
+// Index of the current CPU; used to select a per-CPU cache in lai_acquire_state().
+__attribute__((weak)) unsigned int laihost_current_cpu(void);
+
 #ifdef __cplusplus
 }
 #endif
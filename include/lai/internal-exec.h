@@ -42,45 +42,90 @@ extern "C" {
 #define LAI_BUFFER_INDEX 11
 #define LAI_PACKAGE_INDEX 12
 
+/* Variables are 16 bytes large: the type, a 32-bit index and one 64-bit payload.
+ * Integers are stored inline; all other types store a single pointer (to a head,
+ * a namespace node or an invocation). Index() results and references to ARGx/LOCALx
+ * store their position in the index field. Lazy handles need two pointers; they are
+ * stored in a separate head (see struct lai_lazy_handle). */
+
 typedef struct lai_variable_t {
     int type;
-    uint64_t integer; // for Name()
+    // LAI_ARG_REF, LAI_LOCAL_REF: index of the ARGx or LOCALx.
+    // LAI_*_INDEX: index of the element.
+    uint32_t index;
 
     union {
+        uint64_t integer;
         struct lai_string_head *string_ptr;
         struct lai_buffer_head *buffer_ptr;
         struct lai_pkg_head *pkg_ptr;
-        struct {
-            struct lai_nsnode *unres_ctx_handle;
-            const uint8_t *unres_aml;
-        };
-        struct { // LAI_ARG_REF and LAI_LOCAL_REF.
-            struct lai_invocation *iref_invocation;
-            int iref_index;
-        };
+        struct lai_lazy_handle *lazy_ptr;
+        struct lai_invocation *iref_invocation; // LAI_ARG_REF and LAI_LOCAL_REF.
+        struct lai_nsnode *handle;
     };
+} lai_variable_t;
+
+// Name that is only resolved when the handle is used (e.g., names in package constants).
+struct lai_lazy_handle {
+    lai_rc_t rc;
+    struct lai_nsnode *ctx_handle;
+    const uint8_t *aml;
+};
 
-    struct lai_nsnode *handle;
+/* lai_obj_clone() does not copy strings, buffers and packages. Instead, the content is moved
+ * to a separate head that is shared by the original object and all of its clones.
+ * The rc of the shared head counts the heads that borrow its content.
+ * Before a head is mutated, it gets a private copy of the content (copy-on-write). */
 
-    int index;
-} lai_variable_t;
+/* Short strings and buffers (such as _HID, _UID and small _CRS templates) are stored inline
+ * in the head, such that they do not need a separate content allocation. In this case,
+ * content points to inline_content. Content that grows beyond the inline storage is moved
+ * to the heap by lai_obj_resize_string() and lai_obj_resize_buffer(). */
+
+// Sizes of the inline storage. These are chosen such that heads are 64 bytes large.
+#define LAI_SMALL_STRING_CAPACITY 32
+#define LAI_SMALL_BUFFER_SIZE 32
 
 struct lai_string_head {
     lai_rc_t rc;
+    int in_arena; // Content is allocated from the arena of a lai_state_t.
     size_t capacity;
     char *content;
+    struct lai_string_head *shared; // Head that owns the content (or NULL).
+    char inline_content[LAI_SMALL_STRING_CAPACITY];
 };
 
 struct lai_buffer_head {
     lai_rc_t rc;
+    int in_arena; // Content is allocated from the arena of a lai_state_t.
     size_t size;
     uint8_t *content;
+    struct lai_buffer_head *shared; // Head that owns the content (or NULL).
+    uint8_t inline_content[LAI_SMALL_BUFFER_SIZE];
+};
+
+/* Package heads are allocated together with their elements, from a lai_pkg_block.
+ * lai_create_pkg() allocates one block per package. Constant packages that contain nested
+ * packages (such as _PRT) are built in a single block that holds the entire tree.
+ * Each head in a block holds one reference to the block for its own memory and (as long as
+ * the head owns the elements) one reference for the memory of the elements.
+ * Heads that borrow the elements of another head are allocated from the slab instead. */
+
+struct lai_pkg_block {
+    lai_rc_t rc;
+    size_t size; // Size of the allocation, including this header.
+    size_t used; // Bytes that have already been handed out to packages.
 };
 
 struct lai_pkg_head {
     lai_rc_t rc;
     unsigned int size;
     struct lai_variable_t *elems;
+    struct lai_pkg_head *shared;       // Head that owns the content (or NULL).
+    struct lai_pkg_block *block;       // Block that contains the head (or NULL for slab heads).
+    struct lai_pkg_block *elems_block; // Block that contains elems (or NULL if elems is owned
+                                       // by another head or is a separate allocation).
+    unsigned int capacity;             // Number of elements that elems has room for.
 };
 
 // Allows access to the contents of a string.
@@ -177,6 +222,9 @@ struct lai_invocation {
 
     // Stores a list of all namespace nodes created by this method.
     struct lai_list per_method_list;
+
+    // Links frames that are not in use, see lai_state_t::free_invocations.
+    struct lai_invocation *next_free;
 };
 
 struct lai_ctxitem {
@@ -184,6 +232,7 @@ struct lai_ctxitem {
     uint8_t *code;
     struct lai_nsnode *handle; // Context handle for relative AML names.
     struct lai_invocation *invocation;
+    struct lai_method_ir *ir; // Decoded instructions of code; can be NULL.
 };
 
 // The block stack stores a program counter (PC) and PC limit.
@@ -221,10 +270,12 @@ typedef struct lai_stackitem_ {
             int pkg_index;
             int pkg_phase; // 0: Parse size, 1: Create Object, 2: Enumerate items
             uint8_t pkg_want_result;
+            // Block that nested packages are allocated from (or NULL).
+            struct lai_pkg_block *pkg_block;
         };
         struct {
             int op_opcode;
-            uint8_t op_arg_modes[8];
+            const uint8_t *op_arg_modes; // Points into a static table, see core/exec.c.
             uint8_t op_want_result;
         };
         struct {
@@ -238,10 +289,25 @@ typedef struct lai_stackitem_ {
     };
 } lai_stackitem_t;
 
+/* Temporaries that do not outlive an evaluation (e.g., the results of Concat() and
+ * ToHexString()) take their content from a bump arena in lai_state_t.
+ * Objects that escape the evaluation (return values and stores to the namespace or to
+ * packages) are promoted to the heap by lai_exec_promote(). The arena is reset once the
+ * evaluation is done. Before that, chunks whose objects are all released are reclaimed at
+ * the end of each loop iteration and of each statement of table-level code. */
+
+struct lai_arena_chunk {
+    struct lai_arena_chunk *next;
+    size_t size; // Size of the allocation, including this header.
+    size_t used;
+    size_t live; // Number of objects in the chunk that were not released yet.
+};
+
 #define LAI_SMALL_CTXSTACK_SIZE 8
 #define LAI_SMALL_BLKSTACK_SIZE 8
 #define LAI_SMALL_STACK_SIZE 16
 #define LAI_SMALL_OPSTACK_SIZE 16
+#define LAI_SMALL_INVOCATIONS 2
 
 typedef struct lai_state_t {
     // Base pointers and stack capacities.
@@ -258,10 +324,17 @@ typedef struct lai_state_t {
     int blkstack_ptr; // Stack to track the current block.
     int stack_ptr; // Stack to track the current execution state.
     int opstack_ptr;
+    // Invocation frames that can be reused by the next method call.
+    // This includes the frames in small_invocations that are not in use.
+    struct lai_invocation *free_invocations;
+    // Chunks of the arena for temporaries. Only the first chunk has free space.
+    struct lai_arena_chunk *arena;
+    size_t arena_size; // Total size of all chunks.
     struct lai_ctxitem small_ctxstack[LAI_SMALL_CTXSTACK_SIZE];
     struct lai_blkitem small_blkstack[LAI_SMALL_BLKSTACK_SIZE];
     lai_stackitem_t small_stack[LAI_SMALL_STACK_SIZE];
     struct lai_operand small_opstack[LAI_SMALL_OPSTACK_SIZE];
+    struct lai_invocation small_invocations[LAI_SMALL_INVOCATIONS];
 } lai_state_t;
 
 #ifdef __cplusplus
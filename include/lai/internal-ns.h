@@ -19,10 +19,27 @@ __attribute__((always_inline)) inline void lai_namecpy(char *dest, const char *s
     memcpy(dest, src, 4);
 }
 
+struct lai_nsnode;
+
+// Caches the result of resolving a NameString within a method body.
+struct lai_name_cache_entry {
+    const uint8_t *aml; // Address of the NameString; NULL for empty entries.
+    struct lai_nsnode *ctx_handle;
+    struct lai_nsnode *node; // Can be NULL if the name does not exist.
+    // The entry is only valid if this matches lai_instance::ns_generation.
+    uint64_t generation;
+};
+
 struct lai_aml_segment {
     acpi_aml_t *table;
     // Index of the table (e.g., for SSDTs).
     size_t index;
+
+    // Open addressing hash table of resolved names, keyed by lai_name_cache_entry::aml.
+    // Covers the methods of this table; see lai_do_resolve_cached().
+    struct lai_name_cache_entry *name_cache;
+    size_t name_cache_capacity;
+    size_t name_cache_size;
 };
 
 struct lai_opregion_override {
@@ -66,51 +83,96 @@ enum lai_node_type {
 #define LAI_NAMESPACE_BANK_FIELD 14
 #define LAI_NAMESPACE_OPREGION 15
 
+// Rarely used data that is allocated on demand, see lai_nsnode_ext::overrides.
+struct lai_nsnode_overrides {
+    // Implements the Notify() AML operator.
+    lai_api_error_t (*notify_override)(struct lai_nsnode *, int, void *);
+    void *notify_userptr;
+
+    // Allows the OS to override methods. Mainly useful for _OSI, _OS and _REV.
+    int (*method_override)(lai_variable_t *args, lai_variable_t *result);
+
+    // Allows the OS to override accesses to OperationRegions.
+    const struct lai_opregion_override *op_override;
+    void *op_userptr;
+};
+
+// Payloads of rarely used field types.
+struct lai_index_field {
+    uint64_t offset; // In bits.
+    struct lai_nsnode *index_node;
+    struct lai_nsnode *data_node;
+    uint8_t flags;
+    uint8_t size;
+};
+
+struct lai_bank_field {
+    uint64_t offset; // In bits.
+    struct lai_nsnode *region_node;
+    struct lai_nsnode *bank_node;
+    uint64_t value;
+    uint8_t flags;
+    uint8_t size;
+};
+
+// Out-of-line part of lai_nsnode_t. Only nodes with children, overrides or decoded
+// instructions need it.
+struct lai_nsnode_ext {
+    // Hash table that stores the children, indexed by name.
+    struct lai_hashtable children;
+    // Children in definition order, linked through lai_nsnode_t::next_sibling and prev_sibling.
+    struct lai_nsnode *first_child;
+    struct lai_nsnode *last_child;
+    // Allocated by the first override; NULL otherwise.
+    struct lai_nsnode_overrides *overrides;
+    // Decoded instructions of a method; allocated by its first invocation.
+    struct lai_method_ir *ir;
+};
+
+// The layout of this struct is optimized for name resolution and iteration: all fields
+// that are accessed during lookups are in the first 32 bytes. Nodes are allocated with
+// 64-byte alignment, hence these fields always share a single cache line.
 typedef struct lai_nsnode {
+    // Hot data, used during name resolution.
     char name[4];
     int type;
     struct lai_nsnode *parent;
-    struct lai_aml_segment *amls;
-    void *pointer; // valid for scopes, methods, etc.
-    size_t size; // valid for scopes, methods, etc.
+    // NULL if the node has no children, overrides or decoded instructions.
+    struct lai_nsnode_ext *ext;
+    // Next child of the parent, in definition order.
+    struct lai_nsnode *next_sibling;
 
-    lai_variable_t object; // for Name()
+    // Index of this node in lai_instance::ns_array.
+    size_t ns_index;
+    // Previous child of the parent; only used to unlink the node.
+    struct lai_nsnode *prev_sibling;
 
-    // Implements the Notify() AML operator.
-    lai_api_error_t (*notify_override)(struct lai_nsnode *, int, void *);
-    void *notify_userptr;
+    // Stores a list of all namespace nodes created by the same method.
+    struct lai_list_item per_method_item;
 
-    uint8_t method_flags; // for Methods only, includes ARG_COUNT in lowest three bits
-    // Allows the OS to override methods. Mainly useful for _OSI, _OS and _REV.
-    int (*method_override)(lai_variable_t *args, lai_variable_t *result);
+    lai_variable_t object; // for Name()
 
     // TODO: Find a good mechanism for locks.
     // lai_lock_t mutex;        // for Mutex
 
     union {
+        struct { // LAI_NAMESPACE_METHOD.
+            struct lai_aml_segment *amls;
+            void *pointer;
+            uint32_t size;
+            uint8_t method_flags; // includes ARG_COUNT in lowest three bits
+        };
+
         struct lai_nsnode *al_target; // LAI_NAMESPACE_ALIAS.
 
         struct { // LAI_NAMESPACE_FIELD.
             struct lai_nsnode *fld_region_node;
             uint64_t fld_offset; // In bits.
-            size_t fld_size; // In bits.
+            uint32_t fld_size; // In bits.
             uint8_t fld_flags;
         };
-        struct { // LAI_NAMESPACE_INDEX_FIELD.
-            uint64_t idxf_offset; // In bits.
-            struct lai_nsnode *idxf_index_node;
-            struct lai_nsnode *idxf_data_node;
-            uint8_t idxf_flags;
-            uint8_t idxf_size;
-        };
-        struct { // LAI_NAMESPACE_BANK_FIELD.
-            uint64_t bkf_offset; // In bits.
-            struct lai_nsnode *bkf_region_node;
-            struct lai_nsnode *bkf_bank_node;
-            uint64_t bkf_value;
-            uint8_t bkf_flags;
-            uint8_t bkf_size;
-        };
+        struct lai_index_field *idxf; // LAI_NAMESPACE_INDEX_FIELD.
+        struct lai_bank_field *bkf; // LAI_NAMESPACE_BANK_FIELD.
 
         struct { // LAI_NAMESPACE_BUFFER_FIELD.
             struct lai_buffer_head *bf_buffer;
@@ -123,11 +185,9 @@ typedef struct lai_nsnode {
             uint8_t pblk_len;
         };
         struct { // LAI_NAMESPACE_OPREGION
-            uint8_t op_address_space;
             uint64_t op_base;
             uint64_t op_length;
-            const struct lai_opregion_override *op_override;
-            void *op_userptr;
+            uint8_t op_address_space;
         };
         struct { // LAI_NAMESPACE_MUTEX
             struct lai_sync_state mut_sync;
@@ -136,13 +196,58 @@ typedef struct lai_nsnode {
             struct lai_sync_state evt_sync;
         };
     };
+} lai_nsnode_t;
 
-    // Stores a list of all namespace nodes created by the same method.
-    struct lai_list_item per_method_item;
+// Returns the overrides of a node or NULL.
+__attribute__((always_inline)) inline struct lai_nsnode_overrides *
+lai_ns_get_overrides(lai_nsnode_t *node) {
+    if (!node->ext)
+        return NULL;
+    return node->ext->overrides;
+}
 
-    // Hash table that stores the children of each node.
-    struct lai_hashtable children;
-} lai_nsnode_t;
+// Cache of lai_resolve_path() results, see core/ns.c.
+#define LAI_RESOLVE_CACHE_SIZE 256 // Must be a power of two.
+#define LAI_RESOLVE_CACHE_MAX_PATH 40 // Including the terminating NUL.
+
+struct lai_resolve_cache_entry {
+    // The entry is only valid if this matches lai_instance::ns_generation.
+    uint64_t generation;
+    lai_nsnode_t *ctx_handle;
+    lai_nsnode_t *result; // Can be NULL if the path does not exist.
+    char path[LAI_RESOLVE_CACHE_MAX_PATH];
+};
+
+// Index of all devices and their _HID and _CID, see core/devices.c.
+struct lai_device_id {
+    // EISA IDs (including string IDs in EISA format) are stored as integers;
+    // other string IDs are stored as LAI_DEVICE_ID_STRING | hash of the string.
+    uint64_t key;
+    uint32_t string; // Offset into lai_device_index::strings; only valid for string IDs.
+    lai_nsnode_t *node;
+};
+
+#define LAI_DEVICE_ID_STRING ((uint64_t)1 << 63)
+
+struct lai_device_index {
+    // The index is rebuilt if this does not match lai_instance::device_generation.
+    uint64_t generation;
+
+    // All devices in definition order.
+    lai_nsnode_t **devices;
+    size_t num_devices;
+    size_t devices_capacity;
+
+    // IDs sorted by key (and by string for string IDs). Devices with the same ID appear
+    // in definition order.
+    struct lai_device_id *ids;
+    size_t num_ids;
+    size_t ids_capacity;
+
+    char *strings;
+    size_t strings_size;
+    size_t strings_capacity;
+};
 
 #ifdef __cplusplus
 }
@@ -80,17 +80,56 @@ struct lai_list {
     struct lai_list_item hook;
 };
 
+//---------------------------------------------------------------------------------------
+// Slab allocator for fixed-size objects.
+//---------------------------------------------------------------------------------------
+
+enum lai_slab_cache_id {
+    LAI_SLAB_NSNODE,
+    LAI_SLAB_STRING_HEAD,
+    LAI_SLAB_BUFFER_HEAD,
+    LAI_SLAB_PKG_HEAD,
+    LAI_SLAB_LAZY_HANDLE,
+    LAI_SLAB_INVOCATION,
+    LAI_SLAB_NUM_CACHES
+};
+
+struct lai_slab_stats {
+    const char *name;
+    size_t object_size; // Size of each object (after rounding to the size class).
+    size_t num_slabs; // Number of slabs that were obtained from the host.
+    size_t objects_in_use;
+    size_t objects_free; // Objects on the free list.
+    uint64_t num_allocs;
+    uint64_t num_frees;
+};
+
+struct lai_slab;
+
+struct lai_slab_cache {
+    void *free_list; // Singly linked list of free objects.
+    struct lai_slab *slabs; // All slabs that belong to this cache.
+    struct lai_slab_stats stats;
+};
+
 //---------------------------------------------------------------------------------------
 // Hash table data structure.
 //---------------------------------------------------------------------------------------
 
+// Open addressing hash table with linear probing.
+// Keys are 32-bit integers (e.g., NameSegs) that are stored inline next to the element.
+// Empty slots have elem == NULL and key == 0, tombstones have elem == NULL and
+// key == LAI_HASHTABLE_TOMBSTONE. Neither 0 nor LAI_HASHTABLE_TOMBSTONE are valid keys.
+struct lai_hashtable_slot {
+    uint32_t key;
+    void *elem;
+};
+
 struct lai_hashtable {
-    int elem_capacity; // Capacity of elem_{ptr,hash}_tab.
-    int bucket_capacity; // Size of bucket_tab. *Must* be a power of 2.
+    int capacity; // Size of slots. *Must* be a power of 2.
     int num_elems; // Number of elements in the table.
-    void **elem_ptr_tab; // Stores the pointer of each element.
-    int *elem_hash_tab; // Stores the hash of each element.
-    int *bucket_tab; // Indexes into elem_{ptr,hash}_tab.
+    int num_tombstones; // Number of tombstones in the table.
+    struct lai_hashtable_slot *slots;
 };
 
 #ifdef __cplusplus